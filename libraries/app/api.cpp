@@ -26,6 +26,7 @@
 #include <graphene/app/api.hpp>
 #include <graphene/app/api_access.hpp>
 #include <graphene/app/application.hpp>
+#include <graphene/account_history/account_history_plugin.hpp>
 #include <graphene/chain/database.hpp>
 #include <graphene/chain/get_config.hpp>
 #include <graphene/utilities/key_conversion.hpp>
@@ -142,11 +143,15 @@ namespace graphene { namespace app {
     vector<optional<signed_block>> block_api::get_blocks(uint32_t block_num_from, uint32_t block_num_to)const
     {
        FC_ASSERT( block_num_to >= block_num_from );
-       vector<optional<signed_block>> res;
-       for(uint32_t block_num=block_num_from; block_num<=block_num_to; block_num++) {
-          res.push_back(_db.fetch_block_by_number(block_num));
-       }
-       return res;
+       FC_ASSERT( block_num_to - block_num_from < max_blocks_per_request );
+       return _db.fetch_block_range( block_num_from, block_num_to - block_num_from + 1 );
+    }
+
+    vector<optional<vector<char>>> block_api::get_blocks_raw(uint32_t block_num_from, uint32_t block_num_to)const
+    {
+       FC_ASSERT( block_num_to >= block_num_from );
+       FC_ASSERT( block_num_to - block_num_from < max_blocks_per_request );
+       return _db.fetch_serialized_block_range( block_num_from, block_num_to - block_num_from + 1 );
     }
 
     network_broadcast_api::network_broadcast_api(application& a):_app(a)
@@ -640,20 +645,70 @@ namespace graphene { namespace app {
        if( start == operation_history_id_type() )
           start = node->operation_id;
 
-       while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
+       const auto* by_type_idx = db.get_index_type< primary_index< account_transaction_history_index > >()
+                                   .find_secondary_index<graphene::account_history::history_by_operation_type_index>();
+       if( by_type_idx != nullptr )
        {
-          if( node->operation_id.instance.value <= start.instance.value ) {
+          for( const auto& id : by_type_idx->get_operations( account, { operation_id }, start, stop, limit ) )
+             result.push_back( id(db) );
+       }
+       else
+       {
+          while(node && node->operation_id.instance.value > stop.instance.value && result.size() < limit)
+          {
+             if( node->operation_id.instance.value <= start.instance.value ) {
 
-             if(node->operation_id(db).op.which() == operation_id)
-               result.push_back( node->operation_id(db) );
+                if(node->operation_id(db).op.which() == operation_id)
+                  result.push_back( node->operation_id(db) );
+             }
+             if( node->next == account_transaction_history_id_type() )
+                node = nullptr;
+             else node = &node->next(db);
           }
-          if( node->next == account_transaction_history_id_type() )
-             node = nullptr;
-          else node = &node->next(db);
        }
        if( stop.instance.value == 0 && result.size() < limit ) {
+          // the walk above stops before operation 0; any other operation of the first history
+          // entry was already considered by it
           auto head = db.find(account_transaction_history_id_type());
-          if (head != nullptr && head->account == account && head->operation_id(db).op.which() == operation_id)
+          if (head != nullptr && head->account == account && head->operation_id == operation_history_id_type() &&
+              head->operation_id(db).op.which() == operation_id)
+            result.push_back(head->operation_id(db));
+       }
+       return result;
+    }
+
+
+    vector<operation_history_object> history_api::get_account_history_by_operations( const std::string account_id_or_name,
+                                                                                     flat_set<int> operation_types,
+                                                                                     operation_history_id_type start,
+                                                                                     operation_history_id_type stop,
+                                                                                     unsigned limit ) const
+    {
+       FC_ASSERT( _app.chain_database() );
+       const auto& db = *_app.chain_database();
+       FC_ASSERT( limit <= 100 );
+       const auto* by_type_idx = db.get_index_type< primary_index< account_transaction_history_index > >()
+                                   .find_secondary_index<graphene::account_history::history_by_operation_type_index>();
+       FC_ASSERT( by_type_idx != nullptr, "The account_history plugin is not indexing operation types, see index-operation-types" );
+       vector<operation_history_object> result;
+       account_id_type account;
+       try {
+         account = database_api.get_account_id_from_string(account_id_or_name);
+       } catch (...) { return result; }
+
+       const auto& stats = account(db).statistics(db);
+       if( stats.most_recent_op == account_transaction_history_id_type() ) return result;
+       if( start == operation_history_id_type() )
+          start = stats.most_recent_op(db).operation_id;
+
+       for( const auto& id : by_type_idx->get_operations( account, operation_types, start, stop, limit ) )
+          result.push_back( id(db) );
+       if( stop.instance.value == 0 && result.size() < limit ) {
+          // the walk above stops before operation 0; any other operation of the first history
+          // entry was already considered by it
+          auto head = db.find(account_transaction_history_id_type());
+          if (head != nullptr && head->account == account && head->operation_id == operation_history_id_type() &&
+              operation_types.count( head->operation_id(db).op.which() ))
             result.push_back(head->operation_id(db));
        }
        return result;
@@ -808,22 +863,22 @@ namespace graphene { namespace app {
 
       asset_id_type asset_id = database_api.get_asset_id_from_string( asset );
       const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-      auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
+      const auto& holders_idx = _db.get_index_type< primary_index< account_balance_index > >()
+                                   .get_secondary_index< holders_by_asset_index >();
 
       vector<account_asset_balance> result;
 
-      uint32_t index = 0;
-      for( const account_balance_object& bal : boost::make_iterator_range( range.first, range.second ) )
-      {
-        if( result.size() >= limit )
-            break;
-
-        if( bal.balance.value == 0 )
-            continue;
-
-        if( index++ < start )
-            continue;
+      // balances are sorted by amount, so the holders come before the empty balances of the asset
+      const uint64_t holders = holders_idx.get_holder_count( asset_id );
+      if( start >= holders )
+         return result;
+      const uint64_t end = std::min<uint64_t>( holders, uint64_t(start) + limit );
+      result.reserve( end - start );
 
+      auto itr = bal_idx.nth( bal_idx.rank( bal_idx.lower_bound( boost::make_tuple( asset_id ) ) ) + start );
+      for( uint64_t index = start; index < end; ++index, ++itr )
+      {
+        const account_balance_object& bal = *itr;
         const auto account = _db.find(bal.owner);
 
         account_asset_balance aab;
@@ -839,10 +894,10 @@ namespace graphene { namespace app {
     // get number of asset holders.
     int asset_api::get_asset_holders_count( std::string asset ) const {
 
-      const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+      const auto& holders_idx = _db.get_index_type< primary_index< account_balance_index > >()
+                                   .get_secondary_index< holders_by_asset_index >();
       asset_id_type asset_id = database_api.get_asset_id_from_string( asset );
-      auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
-      int count = boost::distance(range) - 1;
+      int count = holders_idx.get_balance_count( asset_id ) - 1;
 
       return count;
     }
@@ -851,22 +906,13 @@ namespace graphene { namespace app {
 
       vector<asset_holders> result;
 
-      vector<asset_id_type> total_assets;
+      const auto& holders_idx = _db.get_index_type< primary_index< account_balance_index > >()
+                                   .get_secondary_index< holders_by_asset_index >();
       for( const asset_object& asset_obj : _db.get_index_type<asset_index>().indices() )
       {
-        const auto& dasset_obj = asset_obj.dynamic_asset_data_id(_db);
-
-        asset_id_type asset_id;
-        asset_id = dasset_obj.id;
-
-        const auto& bal_idx = _db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
-        auto range = bal_idx.equal_range( boost::make_tuple( asset_id ) );
-
-        int count = boost::distance(range) - 1;
-
         asset_holders ah;
-        ah.asset_id       = asset_id;
-        ah.count     = count;
+        ah.asset_id       = asset_obj.id;
+        ah.count     = holders_idx.get_balance_count( asset_obj.id ) - 1;
 
         result.push_back(ah);
       }
@@ -49,6 +49,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include <iostream>
+#include <list>
 
 #include <fc/log/file_appender.hpp>
 #include <fc/log/logger.hpp>
@@ -380,6 +381,12 @@ namespace detail {
          {
             _chain_db->enable_standby_votes_tracking( _options->at("enable-standby-votes-tracking").as<bool>() );
          }
+
+         if( _options->count("dense-object-lookup") )
+            _chain_db->enable_dense_lookup( _options->at("dense-object-lookup").as<bool>() );
+
+         if( _options->count("replay-stats") )
+            _chain_db->enable_replay_stats( true );
          
          bool replay = false;
          std::string replay_reason = "reason not provided";
@@ -632,13 +639,28 @@ namespace detail {
         // ilog("Request for item ${id}", ("id", id));
          if( id.item_type == graphene::net::block_message_type )
          {
-            auto opt_block = _chain_db->fetch_block_by_id(id.item_hash);
+            auto cached = _served_blocks_by_id.find( id.item_hash );
+            if( cached != _served_blocks_by_id.end() )
+            {
+               _served_blocks.splice( _served_blocks.begin(), _served_blocks, cached->second );
+               return cached->second->second;
+            }
+
+            // the stored bytes are sent as they are, the block is not unpacked and packed again
+            auto opt_block = _chain_db->fetch_serialized_block_by_id(id.item_hash);
             if( !opt_block )
                elog("Couldn't find block ${id} -- corresponding ID in our chain is ${id2}",
                     ("id", id.item_hash)("id2", _chain_db->get_block_id_for_num(block_header::num_from_id(id.item_hash))));
             FC_ASSERT( opt_block.valid() );
-            // ilog("Serving up block #${num}", ("num", opt_block->block_num()));
-            return block_message(std::move(*opt_block));
+            // ilog("Serving up block #${num}", ("num", block_header::num_from_id(id.item_hash)));
+            _served_blocks.emplace_front( id.item_hash, block_message::from_serialized_block( std::move(*opt_block), id.item_hash ) );
+            _served_blocks_by_id[id.item_hash] = _served_blocks.begin();
+            if( _served_blocks.size() > served_block_cache_size )
+            {
+               _served_blocks_by_id.erase( _served_blocks.back().first );
+               _served_blocks.pop_back();
+            }
+            return _served_blocks.front().second;
          }
          return trx_message( _chain_db->get_recent_transaction( id.item_hash ) );
       } FC_CAPTURE_AND_RETHROW( (id) ) }
@@ -896,6 +918,11 @@ namespace detail {
       std::map<string, std::shared_ptr<abstract_plugin>> _available_plugins;
 
       bool _is_finished_syncing = false;
+
+      /** block messages recently served to peers, most recently used first, as peers syncing at the same time ask for the same blocks */
+      static const size_t served_block_cache_size = 256;
+      std::list< std::pair<block_id_type, message> >                                      _served_blocks;
+      std::map< block_id_type, std::list< std::pair<block_id_type, message> >::iterator > _served_blocks_by_id;
    };
 
 }
@@ -935,6 +962,9 @@ void application::set_program_options(boost::program_options::options_descriptio
          ("enable-standby-votes-tracking", bpo::value<bool>()->implicit_value(true),
           "Whether to enable tracking of votes of standby witnesses and committee members. "
           "Set it to true to provide accurate data to API clients, set to false for slightly better performance.")
+         ("dense-object-lookup", bpo::value<bool>()->implicit_value(true),
+          "Whether to look up objects by ID through a table per index instead of searching the index. "
+          "Faster, but uses additional memory for every object ID in use.")
          ("plugins", bpo::value<string>(), "Space-separated list of plugins to activate")
          ;
    command_line_options.add(configuration_file_options);
@@ -944,6 +974,7 @@ void application::set_program_options(boost::program_options::options_descriptio
           "missing fields in a Genesis State will be added, and any unknown fields will be removed. If no file or an "
           "invalid file is found, it will be replaced with an example Genesis State.")
          ("replay-blockchain", "Rebuild object graph by replaying all blocks")
+         ("replay-stats", "Log the time spent reading, decoding and applying blocks while replaying")
          ("resync-blockchain", "Delete all blocks and re-sync with network from scratch")
          ("force-validate", "Force validation of all transactions")
          ("genesis-timestamp", bpo::value<uint32_t>(), "Replace timestamp from genesis.json with current time plus this many seconds (experts only!)")
@@ -188,6 +188,7 @@ class database_api_impl : public std::enable_shared_from_this<database_api_impl>
 
       // Proposed transactions
       vector<proposal_object> get_proposed_transactions( const std::string account_id_or_name )const;
+      vector<proposal_object> list_proposed_transactions( const std::string account_id_or_name, proposal_id_type start, uint32_t limit )const;
 
       // Blinded balances
       vector<blinded_balance_object> get_blinded_balances( const flat_set<commitment_type>& commitments )const;
@@ -1467,39 +1468,42 @@ market_ticker database_api_impl::get_ticker( const string& base, const string& q
     result.quote_volume = 0;
 
     try {
-        const fc::time_point_sec now = fc::time_point::now();
-        const fc::time_point_sec yesterday = fc::time_point_sec( now.sec_since_epoch() - 86400 );
-        const auto batch_size = 100;
-
-        vector<market_trade> trades = get_trade_history( base, quote, now, yesterday, batch_size );
-        if( !trades.empty() )
+        const auto base_id = assets[0]->id;
+        const auto quote_id = assets[1]->id;
+        const auto& ticker_idx = _db.get_index_type<graphene::market_history::market_ticker_index>().indices()
+                                    .get<graphene::market_history::by_market>();
+        auto itr = ticker_idx.find( boost::make_tuple( std::min( base_id, quote_id ), std::max( base_id, quote_id ) ) );
+        if( itr != ticker_idx.end() )
         {
-            result.latest = trades[0].price;
-
-            while( !trades.empty() )
+            // the plugin expires trades as blocks arrive, catch up if there were none for a while
+            const fc::time_point_sec now = fc::time_point::now();
+            graphene::market_history::market_ticker_object expired_ticker;
+            const graphene::market_history::market_ticker_object* ticker = &*itr;
+            if( itr->expiration <= now )
             {
-                for( const market_trade& t: trades )
-                {
-                    result.base_volume += t.value;
-                    result.quote_volume += t.amount;
-                }
-
-                trades = get_trade_history( base, quote, trades.back().date, yesterday, batch_size );
+                expired_ticker = *itr;
+                expired_ticker.expire( now );
+                ticker = &expired_ticker;
             }
 
-            const auto last_trade_yesterday = get_trade_history( base, quote, yesterday, fc::time_point_sec(), 1 );
-            if( !last_trade_yesterday.empty() )
+            // the ticker stores amounts of the asset with the lower ID as base
+            const bool flipped = ticker->base != base_id;
+            auto asset_to_real = [&]( share_type a, int p ) { return double( a.value ) / pow( 10, p ); };
+            auto price_to_real = [&]( share_type ticker_base, share_type ticker_quote ) {
+               if( flipped )
+                  std::swap( ticker_base, ticker_quote );
+               return asset_to_real( ticker_base, assets[0]->precision ) / asset_to_real( ticker_quote, assets[1]->precision );
+            };
+
+            result.latest = price_to_real( ticker->latest_base, ticker->latest_quote );
+            if( !ticker->buckets.empty() )
             {
-                const auto price_yesterday = last_trade_yesterday[0].price;
-                result.percent_change = ( (result.latest / price_yesterday) - 1 ) * 100;
+                result.base_volume = asset_to_real( flipped ? ticker->quote_volume : ticker->base_volume, assets[0]->precision );
+                result.quote_volume = asset_to_real( flipped ? ticker->base_volume : ticker->quote_volume, assets[1]->precision );
+                if( ticker->last_day_base != 0 )
+                   result.percent_change = ( (result.latest / price_to_real( ticker->last_day_base, ticker->last_day_quote )) - 1 ) * 100;
             }
         }
-        else
-        {
-            const auto last_trade = get_trade_history( base, quote, now, fc::time_point_sec(), 1 );
-            if( !last_trade.empty() )
-                result.latest = last_trade[0].price;
-        }
 
         const auto orders = get_order_book( base, quote, 1 );
         if( !orders.asks.empty() ) result.lowest_ask = orders.asks[0].price;
@@ -2362,22 +2366,42 @@ vector<proposal_object> database_api::get_proposed_transactions( const std::stri
    return my->get_proposed_transactions( account_id_or_name );
 }
 
-/** TODO: add secondary index that will accelerate this process */
 vector<proposal_object> database_api_impl::get_proposed_transactions( const std::string account_id_or_name )const
 {
-   const auto& idx = _db.get_index_type<proposal_index>();
+   const auto& pidx = dynamic_cast<const base_primary_index&>( _db.get_index_type<proposal_index>() );
+   const auto& proposals_by_account = pidx.get_secondary_index<graphene::chain::required_approval_index>();
    vector<proposal_object> result;
    const account_id_type id = get_account_from_string(account_id_or_name)->id;
 
-   idx.inspect_all_objects( [&](const object& obj){
-           const proposal_object& p = static_cast<const proposal_object&>(obj);
-           if( p.required_active_approvals.find( id ) != p.required_active_approvals.end() )
-              result.push_back(p);
-           else if ( p.required_owner_approvals.find( id ) != p.required_owner_approvals.end() )
-              result.push_back(p);
-           else if ( p.available_active_approvals.find( id ) != p.available_active_approvals.end() )
-              result.push_back(p);
-   });
+   auto itr = proposals_by_account._account_to_proposals.find( id );
+   if( itr != proposals_by_account._account_to_proposals.end() )
+   {
+      result.reserve( itr->second.size() );
+      for( const proposal_id_type& proposal_id : itr->second )
+         result.push_back( proposal_id(_db) );
+   }
+   return result;
+}
+
+vector<proposal_object> database_api::list_proposed_transactions( const std::string account_id_or_name, proposal_id_type start, uint32_t limit )const
+{
+   return my->list_proposed_transactions( account_id_or_name, start, limit );
+}
+
+vector<proposal_object> database_api_impl::list_proposed_transactions( const std::string account_id_or_name, proposal_id_type start, uint32_t limit )const
+{
+   FC_ASSERT( limit <= 100 );
+   const auto& pidx = dynamic_cast<const base_primary_index&>( _db.get_index_type<proposal_index>() );
+   const auto& proposals_by_account = pidx.get_secondary_index<graphene::chain::required_approval_index>();
+   vector<proposal_object> result;
+   const account_id_type id = get_account_from_string(account_id_or_name)->id;
+
+   auto itr = proposals_by_account._account_to_proposals.find( id );
+   if( itr == proposals_by_account._account_to_proposals.end() )
+      return result;
+
+   for( auto prop_itr = itr->second.lower_bound( start ); prop_itr != itr->second.end() && result.size() < limit; ++prop_itr )
+      result.push_back( (*prop_itr)(_db) );
    return result;
 }
 
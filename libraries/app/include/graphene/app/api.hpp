@@ -121,6 +121,7 @@ namespace graphene { namespace app {
           * @param limit Maximum number of operations to retrieve (must not exceed 100)
           * @param start ID of the most recent operation to retrieve
           * @return A list of operations performed by account, ordered from most recent to oldest.
+          *         Each operation is listed once, including the first one of the account history.
           */
          vector<operation_history_object> get_account_history_operations(const std::string account_id_or_name,
                                                                          int operation_id,
@@ -128,6 +129,24 @@ namespace graphene { namespace app {
                                                                          operation_history_id_type stop = operation_history_id_type(),
                                                                          unsigned limit = 100)const;
 
+         /**
+          * @brief Get only asked operations relevant to the specified account, for several operation types at once
+          * @param account_id_or_name The account ID or name whose history should be queried
+          * @param operation_types The IDs of the operation types we want to get operations for
+          * @param start ID of the most recent operation to retrieve
+          * @param stop ID of the earliest operation to retrieve
+          * @param limit Maximum number of operations to retrieve (must not exceed 100)
+          * @return A list of operations performed by account, ordered from most recent to oldest.
+          *         Each operation is listed once, including the first one of the account history.
+          *
+          * Requires the account_history plugin to run with index-operation-types enabled.
+          */
+         vector<operation_history_object> get_account_history_by_operations(const std::string account_id_or_name,
+                                                                            flat_set<int> operation_types,
+                                                                            operation_history_id_type start = operation_history_id_type(),
+                                                                            operation_history_id_type stop = operation_history_id_type(),
+                                                                            unsigned limit = 100)const;
+
          /**
           * @breif Get operations relevant to the specified account referenced
           * by an event numbering specific to the account. The current number of operations
@@ -164,7 +183,21 @@ namespace graphene { namespace app {
       block_api(graphene::chain::database& db);
       ~block_api();
 
+      /**
+       * @brief Get a range of blocks
+       * @param block_num_from number of the first block
+       * @param block_num_to number of the last block, at most max_blocks_per_request blocks can be requested
+       * @return the blocks, null for block numbers that are not known
+       */
       vector<optional<signed_block>> get_blocks(uint32_t block_num_from, uint32_t block_num_to)const;
+      /**
+       * @brief Get a range of blocks serialized with fc::raw, as they are stored by the node
+       *
+       * This saves the node from unpacking the blocks, for clients that can decode them on their own.
+       */
+      vector<optional<vector<char>>> get_blocks_raw(uint32_t block_num_from, uint32_t block_num_to)const;
+
+      static const uint32_t max_blocks_per_request = 1000;
 
    private:
       graphene::chain::database& _db;
@@ -448,6 +481,7 @@ FC_REFLECT( graphene::app::asset_holders, (asset_id)(count) );
 FC_API(graphene::app::history_api,
        (get_account_history)
        (get_account_history_operations)
+       (get_account_history_by_operations)
        (get_relative_account_history)
        (get_fill_order_history)
        (get_market_history)
@@ -456,6 +490,7 @@ FC_API(graphene::app::history_api,
      )
 FC_API(graphene::app::block_api,
        (get_blocks)
+       (get_blocks_raw)
      )
 FC_API(graphene::app::network_broadcast_api,
        (broadcast_transaction)
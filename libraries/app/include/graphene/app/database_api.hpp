@@ -508,6 +508,9 @@ class database_api
        * @param a String name of the first asset
        * @param b String name of the second asset
        * @return The market ticker for the past 24 hours.
+       *
+       * Trades are counted in intervals of five minutes, so the volume may include trades of up to
+       * five more minutes.  Requires the market_history plugin.
        */
       market_ticker get_ticker( const string& base, const string& quote )const;
 
@@ -775,6 +778,15 @@ class database_api
        */
       vector<proposal_object> get_proposed_transactions( const std::string account_id_or_name )const;
 
+      /**
+       *  @brief Page through the proposed transactions relevant to an account
+       *  @param account_id_or_name the account that is required to approve, or has approved, the proposals
+       *  @param start the ID of the first proposal to return, pass the ID after the last one of a page to get the next page
+       *  @param limit Maximum number of results to return -- must not exceed 100
+       *  @return the proposals in increasing ID order
+       */
+      vector<proposal_object> list_proposed_transactions( const std::string account_id_or_name, proposal_id_type start, uint32_t limit )const;
+
       //////////////////////
       // Blinded balances //
       //////////////////////
@@ -1077,6 +1089,7 @@ FC_API(graphene::app::database_api,
 
    // Proposed transactions
    (get_proposed_transactions)
+   (list_proposed_transactions)
 
    // Blinded balances
    (get_blinded_balances)
@@ -319,6 +319,63 @@ const account_balance_object* balances_by_account_index::get_account_balance( co
    return itr->second;
 }
 
+holders_by_asset_index::counts& holders_by_asset_index::counts_of( const asset_id_type& asset )
+{
+   if( asset_counts.size() <= asset.instance.value )
+      asset_counts.resize( asset.instance.value + 1 );
+   return asset_counts[asset.instance.value];
+}
+
+void holders_by_asset_index::object_inserted( const object& obj )
+{
+   const auto& abo = static_cast< const account_balance_object& >( obj );
+   counts& c = counts_of( abo.asset_type );
+   ++c.balances;
+   if( abo.balance != 0 )
+      ++c.holders;
+}
+
+void holders_by_asset_index::object_removed( const object& obj )
+{
+   const auto& abo = static_cast< const account_balance_object& >( obj );
+   counts& c = counts_of( abo.asset_type );
+   --c.balances;
+   if( abo.balance != 0 )
+      --c.holders;
+}
+
+void holders_by_asset_index::about_to_modify( const object& before )
+{
+   const auto& abo = static_cast< const account_balance_object& >( before );
+   held_before_modify.push( abo.balance != 0 );
+}
+
+void holders_by_asset_index::object_modified( const object& after  )
+{
+   const auto& abo = static_cast< const account_balance_object& >( after );
+   const bool held_before = held_before_modify.top();
+   held_before_modify.pop();
+   const bool held_after = abo.balance != 0;
+   if( held_before == held_after ) return;
+   counts& c = counts_of( abo.asset_type );
+   if( held_after )
+      ++c.holders;
+   else
+      --c.holders;
+}
+
+uint64_t holders_by_asset_index::get_balance_count( const asset_id_type& asset )const
+{
+   if( asset_counts.size() <= asset.instance.value ) return 0;
+   return asset_counts[asset.instance.value].balances;
+}
+
+uint64_t holders_by_asset_index::get_holder_count( const asset_id_type& asset )const
+{
+   if( asset_counts.size() <= asset.instance.value ) return 0;
+   return asset_counts[asset.instance.value].holders;
+}
+
 } } // graphene::chain
 
 GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::account_object )
@@ -464,6 +464,75 @@ void betting_market_object::on_canceled_event(database& db)
    my->state_machine.process_event(canceled_event(db));
 }
 
+void delayed_bet_index::add( const bet_object& bet )
+{
+   if( !bet.end_of_delay ) return;
+   auto& bets = _bets_by_market[bet.betting_market_id];
+   if( !bets.empty() )
+      _next_end_of_delay.erase( std::make_pair( bets.begin()->first.first, bet.betting_market_id ) );
+   bets[ std::make_pair( *bet.end_of_delay, bet_id_type(bet.id) ) ] = &bet;
+   _next_end_of_delay.insert( std::make_pair( bets.begin()->first.first, bet.betting_market_id ) );
+}
+
+void delayed_bet_index::remove( const bet_object& bet )
+{
+   if( !bet.end_of_delay ) return;
+   auto market_itr = _bets_by_market.find( bet.betting_market_id );
+   if( market_itr == _bets_by_market.end() ) return;
+   auto& bets = market_itr->second;
+   _next_end_of_delay.erase( std::make_pair( bets.begin()->first.first, bet.betting_market_id ) );
+   bets.erase( std::make_pair( *bet.end_of_delay, bet_id_type(bet.id) ) );
+   if( bets.empty() )
+      _bets_by_market.erase( market_itr );
+   else
+      _next_end_of_delay.insert( std::make_pair( bets.begin()->first.first, bet.betting_market_id ) );
+}
+
+void delayed_bet_index::object_inserted( const object& obj )
+{
+   add( static_cast<const bet_object&>( obj ) );
+}
+
+void delayed_bet_index::object_removed( const object& obj )
+{
+   remove( static_cast<const bet_object&>( obj ) );
+}
+
+void delayed_bet_index::about_to_modify( const object& before )
+{
+   remove( static_cast<const bet_object&>( before ) );
+}
+
+void delayed_bet_index::object_modified( const object& after )
+{
+   add( static_cast<const bet_object&>( after ) );
+}
+
+vector<bet_id_type> delayed_bet_index::get_bets_due( fc::time_point_sec now,
+                                                     const std::function<bool(betting_market_id_type)>& skip_market )const
+{
+   vector<const bet_object*> due;
+   for( auto itr = _next_end_of_delay.begin(); itr != _next_end_of_delay.end() && itr->first <= now; ++itr )
+   {
+      if( skip_market( itr->second ) )
+         continue;
+      const auto& bets = _bets_by_market.at( itr->second );
+      for( auto bet_itr = bets.begin(); bet_itr != bets.end() && bet_itr->first.first <= now; ++bet_itr )
+         due.push_back( bet_itr->second );
+   }
+
+   // bets must be placed in the same order as when they were taken from the front of the by_odds index
+   const compare_bet_by_odds by_odds;
+   std::sort( due.begin(), due.end(), [&by_odds]( const bet_object* a, const bet_object* b ) {
+      return by_odds( *a, *b );
+   });
+   vector<bet_id_type> result;
+   result.reserve( due.size() );
+   for( const bet_object* bet : due )
+      result.push_back( bet->id );
+   return result;
+}
+
 } } // graphene::chain
 
 namespace fc { 
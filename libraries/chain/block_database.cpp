@@ -23,21 +23,32 @@
  */
 #include <graphene/chain/block_database.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
+#include <graphene/db/thread_pool.hpp>
 #include <fc/io/raw.hpp>
 
-namespace graphene { namespace chain {
+#include <cstring>
 
-struct index_entry
-{
-   uint64_t      block_pos = 0;
-   uint32_t      block_size = 0;
-   block_id_type block_id;
-};
- }}
 FC_REFLECT( graphene::chain::index_entry, (block_pos)(block_size)(block_id) );
 
 namespace graphene { namespace chain {
 
+block_database::~block_database()
+{
+   try
+   {
+      if( is_open() )
+         close();
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Error closing block_database: ${e}", ("e", e.to_detail_string()) );
+   }
+   catch( const std::exception& e )
+   {
+      elog( "Error closing block_database: ${e}", ("e", e.what()) );
+   }
+}
+
 void block_database::open( const fc::path& dbdir )
 { try {
    fc::create_directories(dbdir);
@@ -45,16 +56,24 @@ void block_database::open( const fc::path& dbdir )
    _blocks.exceptions(std::ios_base::failbit | std::ios_base::badbit);
 
    _index_filename = dbdir / "index";
+   _blocks_filename = dbdir / "blocks";
    if( !fc::exists( _index_filename ) )
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out | std::fstream::trunc);
    }
    else
    {
      _block_num_to_pos.open( _index_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
-     _blocks.open( (dbdir/"blocks").generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
+     _blocks.open( _blocks_filename.generic_string().c_str(), std::fstream::binary | std::fstream::in | std::fstream::out );
    }
+
+   _index_size = fc::file_size( _index_filename );
+   _blocks_size = fc::file_size( _blocks_filename );
+   _pending_index.clear();
+   _pending_blocks.clear();
+   map_files();
+   truncate_index();
 } FC_CAPTURE_AND_RETHROW( (dbdir) ) }
 
 bool block_database::is_open()const
@@ -64,16 +83,151 @@ bool block_database::is_open()const
 
 void block_database::close()
 {
+  write_pending();
+  unmap_files();
   _blocks.close();
   _block_num_to_pos.close();
 }
 
 void block_database::flush()
 {
+  write_pending();
   _blocks.flush();
   _block_num_to_pos.flush();
 }
 
+void block_database::flush_irreversible( uint32_t last_irreversible_block_num )
+{
+   if( !_pending_index.empty()
+         && uint64_t(_pending_index.begin()->first) + MAX_PENDING_IRREVERSIBLE_BLOCKS <= last_irreversible_block_num )
+      flush();
+}
+
+void block_database::write_pending()
+{
+   if( !_pending_blocks.empty() )
+   {
+      _blocks.seekp( _blocks_size );
+      _blocks.write( _pending_blocks.data(), _pending_blocks.size() );
+      _blocks.flush();
+      _blocks_size += _pending_blocks.size();
+      _pending_blocks.clear();
+   }
+
+   if( !_pending_index.empty() )
+   {
+      for( const auto& item : _pending_index )
+      {
+         const uint64_t index_pos = uint64_t(sizeof(index_entry)) * item.first;
+         _block_num_to_pos.seekp( index_pos );
+         _block_num_to_pos.write( (const char*)&item.second, sizeof(index_entry) );
+         _index_size = std::max<uint64_t>( _index_size, index_pos + sizeof(index_entry) );
+      }
+      _block_num_to_pos.flush();
+      _pending_index.clear();
+   }
+
+   map_files();
+}
+
+void block_database::map_files()
+{
+   // Only the writers change the size on disk and remap, so the readers never see a region go away
+   if( _index_size > 0 && ( !_index_region || _index_region->get_size() != _index_size ) )
+   {
+      _index_region.reset();
+      if( !_index_mapping )
+         _index_mapping.reset( new fc::file_mapping( _index_filename.generic_string().c_str(), fc::read_only ) );
+      _index_region.reset( new fc::mapped_region( *_index_mapping, fc::read_only, 0, _index_size ) );
+   }
+   if( _blocks_size > 0 && ( !_blocks_region || _blocks_region->get_size() != _blocks_size ) )
+   {
+      _blocks_region.reset();
+      if( !_blocks_mapping )
+         _blocks_mapping.reset( new fc::file_mapping( _blocks_filename.generic_string().c_str(), fc::read_only ) );
+      _blocks_region.reset( new fc::mapped_region( *_blocks_mapping, fc::read_only, 0, _blocks_size ) );
+   }
+}
+
+void block_database::unmap_files()
+{
+   _index_region.reset();
+   _index_mapping.reset();
+   _blocks_region.reset();
+   _blocks_mapping.reset();
+}
+
+bool block_database::read_index_entry( uint32_t block_num, index_entry& e )const
+{
+   auto itr = _pending_index.find( block_num );
+   if( itr != _pending_index.end() )
+   {
+      e = itr->second;
+      return true;
+   }
+
+   const uint64_t index_pos = uint64_t(sizeof(index_entry)) * block_num;
+   if( index_pos + sizeof(index_entry) > _index_size )
+      return false;
+
+   memcpy( (char*)&e, (const char*)_index_region->get_address() + index_pos, sizeof(e) );
+   return true;
+}
+
+vector<index_entry> block_database::read_index_range( uint32_t first_block_num, uint32_t count )const
+{
+   vector<index_entry> entries( count );
+
+   // the entries on disk are contiguous, so copy all of them at once
+   const uint64_t first_index_pos = uint64_t(sizeof(index_entry)) * first_block_num;
+   if( first_index_pos < _index_size )
+   {
+      const uint64_t entries_on_disk = std::min<uint64_t>( (_index_size - first_index_pos) / sizeof(index_entry), count );
+      if( entries_on_disk > 0 )
+      {
+         memcpy( (char*)entries.data(), (const char*)_index_region->get_address() + first_index_pos,
+                 entries_on_disk * sizeof(index_entry) );
+      }
+   }
+
+   const uint64_t end_block_num = uint64_t(first_block_num) + count;
+   for( auto itr = _pending_index.lower_bound( first_block_num ); itr != _pending_index.end() && itr->first < end_block_num; ++itr )
+      entries[itr->first - first_block_num] = itr->second;
+   return entries;
+}
+
+const char* block_database::block_data( const index_entry& e )const
+{
+   if( e.block_size == 0 )
+      return nullptr;
+
+   if( e.block_pos >= _blocks_size )
+   {
+      const uint64_t offset = e.block_pos - _blocks_size;
+      if( offset + e.block_size > _pending_blocks.size() )
+         return nullptr;
+      return _pending_blocks.data() + offset;
+   }
+
+   if( e.block_pos + e.block_size > _blocks_size )
+      return nullptr;
+
+   return (const char*)_blocks_region->get_address() + e.block_pos;
+}
+
+optional<signed_block> block_database::unpack_block( const index_entry& e )const
+{
+   const char* data = block_data( e );
+   if( data == nullptr )
+      return optional<signed_block>();
+
+   fc::datastream<const char*> ds( data, e.block_size );
+   signed_block result;
+   fc::raw::unpack( ds, result );
+   FC_ASSERT( result.id() == e.block_id );
+   return result;
+}
+
 void block_database::store( const block_id_type& _id, const signed_block& b )
 {
    block_id_type id = _id;
@@ -83,33 +237,35 @@ void block_database::store( const block_id_type& _id, const signed_block& b )
       elog( "id argument of block_database::store() was not initialized for block ${id}", ("id", id) );
    }
    auto num = block_header::num_from_id(id);
-   _block_num_to_pos.seekp( sizeof( index_entry ) * num );
+
+   // pack straight into the pending buffer, it is written out with the rest of the batch
+   const size_t old_size = _pending_blocks.size();
+   const size_t block_size = fc::raw::pack_size( b );
+   _pending_blocks.resize( old_size + block_size );
+   fc::datastream<char*> ds( _pending_blocks.data() + old_size, block_size );
+   fc::raw::pack( ds, b );
+
    index_entry e;
-   _blocks.seekp( 0, _blocks.end );
-   auto vec = fc::raw::pack( b );
-   e.block_pos  = _blocks.tellp();
-   e.block_size = vec.size();
+   e.block_pos  = _blocks_size + old_size;
+   e.block_size = block_size;
    e.block_id   = id;
-   _blocks.write( vec.data(), vec.size() );
-   _block_num_to_pos.write( (char*)&e, sizeof(e) );
+   _pending_index[num] = e;
+
+   if( _pending_blocks.size() >= MAX_PENDING_BYTES )
+      write_pending();
 }
 
 void block_database::remove( const block_id_type& id )
 { try {
    index_entry e;
-   auto index_pos = sizeof(e)*block_header::num_from_id(id);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= index_pos )
+   auto num = block_header::num_from_id(id);
+   if( !read_index_entry( num, e ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block ${id} not contained in block database", ("id", id));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
    if( e.block_id == id )
    {
       e.block_size = 0;
-      _block_num_to_pos.seekp( sizeof(e)*block_header::num_from_id(id) );
-      _block_num_to_pos.write( (char*)&e, sizeof(e) );
+      _pending_index[num] = e;
    }
 } FC_CAPTURE_AND_RETHROW( (id) ) }
 
@@ -119,12 +275,8 @@ bool block_database::contains( const block_id_type& id )const
       return false;
 
    index_entry e;
-   auto index_pos = sizeof(e)*block_header::num_from_id(id);
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() < index_pos + sizeof(e) )
+   if( !read_index_entry( block_header::num_from_id(id), e ) )
       return false;
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
 
    return e.block_id == id && e.block_size > 0;
 }
@@ -133,14 +285,9 @@ block_id_type block_database::fetch_block_id( uint32_t block_num )const
 {
    assert( block_num != 0 );
    index_entry e;
-   auto index_pos = sizeof(e)*block_num;
-   _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-   if ( _block_num_to_pos.tellg() <= int64_t(index_pos) )
+   if( !read_index_entry( block_num, e ) )
       FC_THROW_EXCEPTION(fc::key_not_found_exception, "Block number ${block_num} not contained in block database", ("block_num", block_num));
 
-   _block_num_to_pos.seekg( index_pos );
-   _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
    FC_ASSERT( e.block_id != block_id_type(), "Empty block_id in block_database (maybe corrupt on disk?)" );
    return e.block_id;
 }
@@ -150,23 +297,12 @@ optional<signed_block> block_database::fetch_optional( const block_id_type& id )
    try
    {
       index_entry e;
-      auto index_pos = sizeof(e)*block_header::num_from_id(id);
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      if( !read_index_entry( block_header::num_from_id(id), e ) )
          return {};
 
-      _block_num_to_pos.seekg( index_pos );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
       if( e.block_id != id ) return optional<signed_block>();
 
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      if (e.block_size)
-         _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
-      return result;
+      return unpack_block( e );
    }
    catch (const fc::exception&)
    {
@@ -182,20 +318,10 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    try
    {
       index_entry e;
-      auto index_pos = sizeof(e)*block_num;
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      if ( _block_num_to_pos.tellg() <= index_pos )
+      if( !read_index_entry( block_num, e ) )
          return {};
 
-      _block_num_to_pos.seekg( index_pos, _block_num_to_pos.beg );
-      _block_num_to_pos.read( (char*)&e, sizeof(e) );
-
-      vector<char> data( e.block_size );
-      _blocks.seekg( e.block_pos );
-      _blocks.read( data.data(), e.block_size );
-      auto result = fc::raw::unpack<signed_block>(data);
-      FC_ASSERT( result.id() == e.block_id );
-      return result;
+      return unpack_block( e );
    }
    catch (const fc::exception&)
    {
@@ -206,38 +332,78 @@ optional<signed_block> block_database::fetch_by_number( uint32_t block_num )cons
    return optional<signed_block>();
 }
 
-optional<index_entry> block_database::last_index_entry()const {
-   try
+optional<vector<char>> block_database::fetch_serialized_by_number( uint32_t block_num )const
+{
+   index_entry e;
+   if( !read_index_entry( block_num, e ) )
+      return optional<vector<char>>();
+
+   const char* data = block_data( e );
+   if( data == nullptr )
+      return optional<vector<char>>();
+   return vector<char>( data, data + e.block_size );
+}
+
+vector<optional<signed_block>> block_database::fetch_range( uint32_t first_block_num, uint32_t count )const
+{
+   const vector<index_entry> entries = read_index_range( first_block_num, count );
+   vector<optional<signed_block>> result( count );
+   db::thread_pool::shared().run_for_each( count, [&entries,&result,this]( size_t i ) {
+      try
+      {
+         result[i] = unpack_block( entries[i] );
+      }
+      catch (const fc::exception&)
+      {
+      }
+      catch (const std::exception&)
+      {
+      }
+   });
+   return result;
+}
+
+vector<optional<vector<char>>> block_database::fetch_serialized_range( uint32_t first_block_num, uint32_t count )const
+{
+   const vector<index_entry> entries = read_index_range( first_block_num, count );
+   vector<optional<vector<char>>> result( count );
+   for( uint32_t i = 0; i < count; ++i )
    {
-      index_entry e;
+      const char* data = block_data( entries[i] );
+      if( data != nullptr )
+         result[i] = vector<char>( data, data + entries[i].block_size );
+   }
+   return result;
+}
 
-      _block_num_to_pos.seekg( 0, _block_num_to_pos.end );
-      std::streampos pos = _block_num_to_pos.tellg();
-      if( pos < sizeof(index_entry) )
-         return optional<index_entry>();
+optional<vector<char>> block_database::fetch_serialized( const block_id_type& id )const
+{
+   index_entry e;
+   if( !read_index_entry( block_header::num_from_id(id), e ) || e.block_id != id )
+      return optional<vector<char>>();
 
-      pos -= pos % sizeof(index_entry);
+   const char* data = block_data( e );
+   if( data == nullptr )
+      return optional<vector<char>>();
+   return vector<char>( data, data + e.block_size );
+}
 
-      _blocks.seekg( 0, _block_num_to_pos.end );
-      const std::streampos blocks_size = _blocks.tellg();
+void block_database::truncate_index()
+{
+   try
+   {
+      // drop the entries at the end of the index that do not point to a complete block,
+      // e.g. because the process died between writing the blocks and the index
+      uint64_t pos = _index_size - _index_size % sizeof(index_entry);
       while( pos > 0 )
       {
-         pos -= sizeof(index_entry);
-         _block_num_to_pos.seekg( pos );
-         _block_num_to_pos.read( (char*)&e, sizeof(e) );
-         if( _block_num_to_pos.gcount() == sizeof(e) && e.block_size > 0
-                && e.block_pos + e.block_size <= blocks_size )
+         index_entry e;
+         memcpy( (char*)&e, (const char*)_index_region->get_address() + pos - sizeof(index_entry), sizeof(e) );
+         if( e.block_size > 0 && e.block_pos + e.block_size <= _blocks_size )
             try
             {
-               vector<char> data( e.block_size );
-               _blocks.seekg( e.block_pos );
-               _blocks.read( data.data(), e.block_size );
-               if( _blocks.gcount() == e.block_size )
-               {
-                  const signed_block block = fc::raw::unpack<signed_block>(data);
-                  if( block.id() == e.block_id )
-                     return e;
-               }
+               if( unpack_block( e ).valid() )
+                  break;
             }
             catch (const fc::exception&)
             {
@@ -245,7 +411,17 @@ optional<index_entry> block_database::last_index_entry()const {
             catch (const std::exception&)
             {
             }
+         pos -= sizeof(index_entry);
+      }
+
+      if( pos < _index_size )
+      {
+         // the region must not be mapped while the file is truncated
+         _index_region.reset();
+         _index_mapping.reset();
          fc::resize_file( _index_filename, pos );
+         _index_size = pos;
+         map_files();
       }
    }
    catch (const fc::exception&)
@@ -254,6 +430,31 @@ optional<index_entry> block_database::last_index_entry()const {
    catch (const std::exception&)
    {
    }
+}
+
+optional<index_entry> block_database::last_index_entry()const
+{
+   // the entries on disk were checked by open(), the pending ones replace them
+   auto pending = _pending_index.rbegin();
+   uint64_t entries_on_disk = _index_size / sizeof(index_entry);
+   while( pending != _pending_index.rend() || entries_on_disk > 0 )
+   {
+      if( pending != _pending_index.rend() && uint64_t(pending->first) + 1 >= entries_on_disk )
+      {
+         entries_on_disk = std::min<uint64_t>( entries_on_disk, pending->first );
+         if( pending->second.block_size > 0 )
+            return pending->second;
+         ++pending;
+      }
+      else
+      {
+         --entries_on_disk;
+         index_entry e;
+         memcpy( (char*)&e, (const char*)_index_region->get_address() + entries_on_disk * sizeof(index_entry), sizeof(e) );
+         if( e.block_size > 0 )
+            return e;
+      }
+   }
    return optional<index_entry>();
 }
 
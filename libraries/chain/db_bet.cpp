@@ -419,17 +419,28 @@ bool bet_was_matched(database& db, const bet_object& bet,
    }
 }
 
+namespace {
+
 /**
- *  Matches the two orders,
- *
- *  @return a bit field indicating which orders were filled (and thus removed)
+ *  How much of a taker bet and a maker bet match each other, at the maker's odds
+ */
+struct bet_fill
+{
+   const bet_object* maker_bet = nullptr;
+   share_type        maker_amount_to_match;
+   share_type        taker_amount_to_match;
+   /** the part of the taker's stake that is returned because it was matched at better odds than asked */
+   share_type        taker_refund_amount;
+   /** maker bets will always be an exact multiple of maker_odds_ratio, so they will either completely match or remain on the books */
+   bool              maker_bet_will_completely_match = false;
+};
+
+/**
+ *  Computes how the taker bet, in its current state, matches the maker bet without changing anything
  *
- *  0 - no bet was matched (this will never happen)
- *  1 - taker_bet was filled and removed from the books
- *  2 - maker_bet was filled and removed from the books
- *  3 - both were filled and removed from the books
+ *  @return false if nothing can be matched
  */
-int match_bet(database& db, const bet_object& taker_bet, const bet_object& maker_bet )
+bool compute_bet_fill(const bet_object& taker_bet, const bet_object& maker_bet, bet_fill& fill)
 {
    //fc_idump(fc::logger::get("betting"), (taker_bet)(maker_bet));
    assert(taker_bet.amount_to_bet.asset_id == maker_bet.amount_to_bet.asset_id);
@@ -438,8 +449,7 @@ int match_bet(database& db, const bet_object& taker_bet, const bet_object& maker
                                                     taker_bet.backer_multiplier >= maker_bet.backer_multiplier);
    assert(taker_bet.back_or_lay != maker_bet.back_or_lay);
 
-   int result = 0;
-   //fc_idump(fc::logger::get("betting"), (taker_bet)(maker_bet));
+   fill.maker_bet = &maker_bet;
 
    // using the maker's odds, figure out how much of the maker's bet we would match, rounding down
    // go ahead and get look up the ratio for the bet (a bet with odds 1.92 will have a ratio 25:23)
@@ -481,7 +491,7 @@ int match_bet(database& db, const bet_object& taker_bet, const bet_object& maker
    // TODO: analyze whether maximum_maker_amount_to_match can ever be zero here 
    assert(maker_amount_to_match != 0);
    if (maker_amount_to_match == 0)
-      return 0;
+      return false;
 
 #ifndef NDEBUG
    assert(taker_amount_to_match <= taker_bet.amount_to_bet.amount);
@@ -498,10 +508,12 @@ int match_bet(database& db, const bet_object& taker_bet, const bet_object& maker
 
    //fc_idump(fc::logger::get("betting"), (taker_amount_to_match)(maker_amount_to_match));
 
-   // maker bets will always be an exact multiple of maker_odds_ratio, so they will either completely match or remain on the books
-   bool maker_bet_will_completely_match = maker_amount_to_match == maker_bet.amount_to_bet.amount;
+   fill.maker_amount_to_match = maker_amount_to_match;
+   fill.taker_amount_to_match = taker_amount_to_match;
+   fill.maker_bet_will_completely_match = maker_amount_to_match == maker_bet.amount_to_bet.amount;
+   fill.taker_refund_amount = 0;
 
-   if (maker_bet_will_completely_match && taker_amount_to_match != taker_bet.amount_to_bet.amount)
+   if (fill.maker_bet_will_completely_match && taker_amount_to_match != taker_bet.amount_to_bet.amount)
    {
       // then the taker bet will stay on the books.  If the taker odds != the maker odds, we will
       // need to refund the stake the taker was expecting to pay but didn't.
@@ -514,7 +526,6 @@ int match_bet(database& db, const bet_object& taker_bet, const bet_object& maker
       std::tie(takers_odds_back_odds_ratio, takers_odds_lay_odds_ratio) = taker_bet.get_ratio();
       const share_type& takers_odds_taker_odds_ratio = taker_bet.back_or_lay == bet_type::back ? takers_odds_back_odds_ratio : takers_odds_lay_odds_ratio;
       const share_type& takers_odds_maker_odds_ratio = taker_bet.back_or_lay == bet_type::back ? takers_odds_lay_odds_ratio : takers_odds_back_odds_ratio;
-      share_type taker_refund_amount;
 
       if (taker_bet.back_or_lay == bet_type::back)
       {
@@ -522,7 +533,7 @@ int match_bet(database& db, const bet_object& taker_bet, const bet_object& maker
          // may not be an even multiple of the taker's odds; round it down.
          share_type taker_remaining_factor = (taker_bet.amount_to_bet.amount - taker_amount_to_match) / takers_odds_taker_odds_ratio;
          share_type taker_remaining_bet_amount = taker_remaining_factor * takers_odds_taker_odds_ratio;
-         taker_refund_amount = taker_bet.amount_to_bet.amount - taker_amount_to_match - taker_remaining_bet_amount;
+         fill.taker_refund_amount = taker_bet.amount_to_bet.amount - taker_amount_to_match - taker_remaining_bet_amount;
          //idump((taker_remaining_factor)(taker_remaining_bet_amount)(taker_refund_amount));
       }
       else
@@ -537,43 +548,161 @@ int match_bet(database& db, const bet_object& taker_bet, const bet_object& maker
          // because we matched at the maker's odds and not the taker's odds, the remaining amount to match
          // may not be an even multiple of the taker's odds; round it down.
          share_type taker_remaining_factor = unrounded_taker_remaining_amount_to_match / takers_odds_maker_odds_ratio;
-         share_type taker_remaining_maker_amount_to_match = taker_remaining_factor * takers_odds_maker_odds_ratio;
          share_type taker_remaining_bet_amount = taker_remaining_factor * takers_odds_taker_odds_ratio;
 
-         taker_refund_amount = taker_bet.amount_to_bet.amount - taker_amount_to_match - taker_remaining_bet_amount;
-         //idump((taker_remaining_factor)(taker_remaining_maker_amount_to_match)(taker_remaining_bet_amount)(taker_refund_amount));
+         fill.taker_refund_amount = taker_bet.amount_to_bet.amount - taker_amount_to_match - taker_remaining_bet_amount;
+         //idump((taker_remaining_factor)(taker_remaining_bet_amount)(taker_refund_amount));
       }
+   }
+   return true;
+}
 
-      if (taker_refund_amount > share_type())
-      {
-         db.modify(taker_bet, [&taker_refund_amount](bet_object& taker_bet_object) {
-                      taker_bet_object.amount_to_bet.amount -= taker_refund_amount;
-                   });
-         fc_dlog(fc::logger::get("betting"), "Refunding ${taker_refund_amount} to taker because we matched at the maker's odds of "
-                 "${maker_odds} instead of the taker's odds ${taker_odds}",
-                 ("taker_refund_amount", taker_refund_amount)
-                 ("maker_odds", maker_bet.backer_multiplier)
-                 ("taker_odds", taker_bet.backer_multiplier));
-         fc_ddump(fc::logger::get("betting"), (taker_bet));
-
-         db.adjust_balance(taker_bet.bettor_id, asset(taker_refund_amount, taker_bet.amount_to_bet.asset_id));
-         // TODO: update global statistics
-         bet_adjusted_operation bet_adjusted_op(taker_bet.bettor_id, taker_bet.id, 
-                                                asset(taker_refund_amount, taker_bet.amount_to_bet.asset_id));
-         // fc_idump(fc::logger::get("betting"), (bet_adjusted_op)(new_bet_object));
-         db.push_applied_operation(std::move(bet_adjusted_op));
-      }
+void log_taker_refund(const bet_object& taker_bet, const bet_fill& fill)
+{
+   fc_dlog(fc::logger::get("betting"), "Refunding ${taker_refund_amount} to taker because we matched at the maker's odds of "
+           "${maker_odds} instead of the taker's odds ${taker_odds}",
+           ("taker_refund_amount", fill.taker_refund_amount)
+           ("maker_odds", fill.maker_bet->backer_multiplier)
+           ("taker_odds", taker_bet.backer_multiplier));
+}
+
+} // end anonymous namespace
+
+/**
+ *  Matches the two orders,
+ *
+ *  @return a bit field indicating which orders were filled (and thus removed)
+ *
+ *  0 - no bet was matched (this will never happen)
+ *  1 - taker_bet was filled and removed from the books
+ *  2 - maker_bet was filled and removed from the books
+ *  3 - both were filled and removed from the books
+ */
+int match_bet(database& db, const bet_object& taker_bet, const bet_object& maker_bet )
+{
+   int result = 0;
+   bet_fill fill;
+   if (!compute_bet_fill(taker_bet, maker_bet, fill))
+      return 0;
+
+   if (fill.taker_refund_amount > share_type())
+   {
+      const share_type taker_refund_amount = fill.taker_refund_amount;
+      db.modify(taker_bet, [&taker_refund_amount](bet_object& taker_bet_object) {
+                   taker_bet_object.amount_to_bet.amount -= taker_refund_amount;
+                });
+      log_taker_refund(taker_bet, fill);
+      fc_ddump(fc::logger::get("betting"), (taker_bet));
+
+      db.adjust_balance(taker_bet.bettor_id, asset(taker_refund_amount, taker_bet.amount_to_bet.asset_id));
+      // TODO: update global statistics
+      bet_adjusted_operation bet_adjusted_op(taker_bet.bettor_id, taker_bet.id, 
+                                             asset(taker_refund_amount, taker_bet.amount_to_bet.asset_id));
+      // fc_idump(fc::logger::get("betting"), (bet_adjusted_op)(new_bet_object));
+      db.push_applied_operation(std::move(bet_adjusted_op));
    }
 
    // if the maker bet stays on the books, we need to make sure the taker bet is removed from the books (either it fills completely,
    // or any un-filled amount is canceled)
-   result |= bet_was_matched(db, taker_bet, taker_amount_to_match, maker_amount_to_match, maker_bet.backer_multiplier, !maker_bet_will_completely_match);
-   result |= bet_was_matched(db, maker_bet, maker_amount_to_match, taker_amount_to_match, maker_bet.backer_multiplier, false) << 1;
+   result |= bet_was_matched(db, taker_bet, fill.taker_amount_to_match, fill.maker_amount_to_match, maker_bet.backer_multiplier, !fill.maker_bet_will_completely_match);
+   result |= bet_was_matched(db, maker_bet, fill.maker_amount_to_match, fill.taker_amount_to_match, maker_bet.backer_multiplier, false) << 1;
 
    assert(result != 0);
    return result;
 }
 
+/**
+ *  Matches the taker bet against the given fills, computed in advance by compute_bet_fill() on a copy of the
+ *  taker bet.  Has the same effect as calling match_bet() for each of them, but the taker's bet, balance and
+ *  position are only updated once, before the last maker bet, instead of once per maker bet.
+ *
+ *  Must not be used when one of the maker bets belongs to the taker, since both would change the same position.
+ *  The fills must not be empty.
+ *
+ *  @return true if the taker bet was removed from the books
+ */
+bool apply_bet_fills(database& db, const bet_object& taker_bet, const vector<bet_fill>& fills, share_type remaining_amount)
+{
+   const asset_id_type asset_id = taker_bet.amount_to_bet.asset_id;
+   share_type taker_balance_delta;
+   optional<betting_market_position_object> taker_position;
+   const betting_market_position_object* taker_position_object = nullptr;
+   bool taker_bet_removed = false;
+
+   auto finish_taker_bet = [&]() {
+      if (taker_position_object && fills.size() > 1)
+         db.modify(*taker_position_object, [&taker_position](betting_market_position_object& position) {
+            position = *taker_position;
+         });
+      db.adjust_balance(taker_bet.bettor_id, asset(taker_balance_delta, asset_id));
+
+      if (remaining_amount == share_type())
+      {
+         db.remove(taker_bet);
+         return true;
+      }
+      db.modify(taker_bet, [&remaining_amount](bet_object& bet_obj) {
+         bet_obj.amount_to_bet.amount = remaining_amount;
+      });
+      if (!fills.back().maker_bet_will_completely_match)
+      {
+         // the maker bet stays on the books, so the rest of the taker bet is canceled
+         db.cancel_bet(taker_bet);
+         return true;
+      }
+      return false;
+   };
+
+   for (const bet_fill& fill : fills)
+   {
+      if (fill.taker_refund_amount > share_type())
+      {
+         log_taker_refund(taker_bet, fill);
+         taker_balance_delta += fill.taker_refund_amount;
+         bet_adjusted_operation bet_adjusted_op(taker_bet.bettor_id, taker_bet.id, asset(fill.taker_refund_amount, asset_id));
+         db.push_applied_operation(std::move(bet_adjusted_op));
+      }
+
+      share_type guaranteed_winnings_returned;
+      if (!taker_position)
+      {
+         // the first fill goes to the database, which creates the position at the same point as match_bet() would
+         guaranteed_winnings_returned = adjust_betting_position(db, taker_bet.bettor_id, taker_bet.betting_market_id,
+                                                                taker_bet.back_or_lay, fill.taker_amount_to_match, fill.maker_amount_to_match);
+         const auto& index = db.get_index_type<betting_market_position_index>().indices().get<by_bettor_betting_market>();
+         auto itr = index.find(boost::make_tuple(taker_bet.bettor_id, taker_bet.betting_market_id));
+         if (itr != index.end())
+         {
+            taker_position_object = &*itr;
+            taker_position = *itr;
+         }
+      }
+      else if (fill.taker_amount_to_match > share_type())
+      {
+         // the same as adjust_betting_position() modifying an existing position
+         share_type amount = fill.taker_amount_to_match + fill.maker_amount_to_match;
+         taker_position->pay_if_payout_condition += taker_bet.back_or_lay == bet_type::back ? amount : 0;
+         taker_position->pay_if_not_payout_condition += taker_bet.back_or_lay == bet_type::lay ? amount : 0;
+         taker_position->pay_if_canceled += fill.taker_amount_to_match;
+         guaranteed_winnings_returned = taker_position->reduce();
+      }
+      taker_balance_delta += guaranteed_winnings_returned;
+
+      bet_matched_operation bet_matched_virtual_op(taker_bet.bettor_id, taker_bet.id,
+                                                   asset(fill.taker_amount_to_match, asset_id),
+                                                   fill.maker_bet->backer_multiplier,
+                                                   guaranteed_winnings_returned);
+      db.push_applied_operation(std::move(bet_matched_virtual_op));
+
+      // match_bet() finishes the taker bet before the maker bet, so a canceled rest of the taker bet
+      // is reported before the last maker bet is matched
+      if (&fill == &fills.back())
+         taker_bet_removed = finish_taker_bet();
+
+      bet_was_matched(db, *fill.maker_bet, fill.maker_amount_to_match, fill.taker_amount_to_match, fill.maker_bet->backer_multiplier, false);
+   }
+   return taker_bet_removed;
+}
 
 // called from the bet_place_evaluator
 bool database::place_bet(const bet_object& new_bet_object)
@@ -623,6 +752,34 @@ bool database::place_bet(const bet_object& new_bet_object)
    //    fc_idump(fc::logger::get("betting"), (*itr));
    // fc_ilog(fc::logger::get("betting"), "------------  order book ------------------");
 
+   // Compute all fills against the book on a copy of the taker bet first.  Each maker bet still has to be
+   // updated on its own, but the taker's bet, balance and position are then updated once for all of them.
+   bet_object taker_bet = new_bet_object;
+   vector<bet_fill> fills;
+   bool taker_is_maker = false;
+   for (auto itr = book_itr; itr != book_end; ++itr)
+   {
+      bet_fill fill;
+      if (!compute_bet_fill(taker_bet, *itr, fill))
+         break;
+      taker_is_maker |= itr->bettor_id == new_bet_object.bettor_id;
+      fills.push_back(fill);
+      taker_bet.amount_to_bet.amount -= fill.taker_refund_amount + fill.taker_amount_to_match;
+
+      // we continue if the maker bet was completely consumed AND the taker bet was not
+      if (!fill.maker_bet_will_completely_match || taker_bet.amount_to_bet.amount == share_type())
+         break;
+   }
+
+   if (!taker_is_maker && get_node_properties().batched_bet_matching)
+   {
+      bool taker_bet_removed = !fills.empty() && apply_bet_fills(*this, new_bet_object, fills, taker_bet.amount_to_bet.amount);
+      if (!taker_bet_removed)
+         fc_ddump(fc::logger::get("betting"), (new_bet_object));
+      return taker_bet_removed;
+   }
+
+   // a bettor matching their own bets changes the same position as taker and maker, match one bet at a time
    int orders_matched_flags = 0;
    bool finished = false;
    while (!finished && book_itr != book_end)
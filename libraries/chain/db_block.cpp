@@ -40,6 +40,7 @@
 #include <graphene/chain/exceptions.hpp>
 #include <graphene/chain/evaluator.hpp>
 #include <graphene/chain/witness_schedule_object.hpp>
+#include <graphene/db/thread_pool.hpp>
 #include <fc/crypto/digest.hpp>
 
 
@@ -113,6 +114,14 @@ optional<signed_block> database::fetch_block_by_id( const block_id_type& id )con
    return b->data;
 }
 
+optional<vector<char>> database::fetch_serialized_block_by_id( const block_id_type& id )const
+{
+   auto b = _fork_db.fetch_block( id );
+   if( !b )
+      return _block_id_to_block.fetch_serialized(id);
+   return fc::raw::pack( b->data );
+}
+
 optional<signed_block> database::fetch_block_by_number( uint32_t num )const
 {
    auto results = _fork_db.fetch_block_by_number(num);
@@ -123,6 +132,31 @@ optional<signed_block> database::fetch_block_by_number( uint32_t num )const
    return optional<signed_block>();
 }
 
+vector<optional<signed_block>> database::fetch_block_range( uint32_t first_block_num, uint32_t count )const
+{
+   vector<optional<signed_block>> result = _block_id_to_block.fetch_range( first_block_num, count );
+   // as in fetch_block_by_number(), a block on the current fork takes precedence over the stored one
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      auto fork_blocks = _fork_db.fetch_block_by_number( first_block_num + i );
+      if( fork_blocks.size() == 1 )
+         result[i] = fork_blocks[0]->data;
+   }
+   return result;
+}
+
+vector<optional<vector<char>>> database::fetch_serialized_block_range( uint32_t first_block_num, uint32_t count )const
+{
+   vector<optional<vector<char>>> result = _block_id_to_block.fetch_serialized_range( first_block_num, count );
+   for( uint32_t i = 0; i < count; ++i )
+   {
+      auto fork_blocks = _fork_db.fetch_block_by_number( first_block_num + i );
+      if( fork_blocks.size() == 1 )
+         result[i] = fc::raw::pack( fork_blocks[0]->data );
+   }
+   return result;
+}
+
 const signed_transaction& database::get_recent_transaction(const transaction_id_type& trx_id) const
 {
    auto& index = get_index_type<transaction_index>().indices().get<by_trx_id>();
@@ -173,6 +207,37 @@ void database::check_transaction_for_duplicated_operations(const signed_transact
    }
 }
 
+void database::precompute_parallel( const vector<const signed_block*>& blocks, uint32_t skip )const
+{ try {
+   if( skip & (skip_transaction_signatures | skip_authority_check) )
+      return;
+
+   vector<const signed_transaction*> transactions;
+   for( const signed_block* block : blocks )
+      for( const auto& trx : block->transactions )
+         if( trx.signees.empty() && !trx.signatures.empty() )
+            transactions.push_back( &trx );
+   if( transactions.empty() )
+      return;
+
+   const chain_id_type& chain_id = get_chain_id();
+   db::thread_pool::shared().run_for_each( transactions.size(), [&transactions,&chain_id]( size_t i ) {
+      try
+      {
+         transactions[i]->get_signature_keys( chain_id );
+      }
+      catch( const fc::exception& )
+      {
+         // invalid signatures are reported when the transaction is applied
+      }
+   });
+} FC_CAPTURE_AND_RETHROW() }
+
+void database::precompute_parallel( const signed_block& block, uint32_t skip )const
+{
+   precompute_parallel( vector<const signed_block*>{ &block }, skip );
+}
+
 /**
  * Push block "may fail" in which case every partial change is unwound.  After
  * push block is successful the block is appended to the chain database on disk.
@@ -182,6 +247,7 @@ void database::check_transaction_for_duplicated_operations(const signed_transact
 bool database::push_block(const signed_block& new_block, uint32_t skip)
 {
 //   idump((new_block.block_num())(new_block.id())(new_block.timestamp)(new_block.previous));
+   precompute_parallel( new_block, skip );
    bool result;
    detail::with_skip_flags( *this, skip, [&]()
    {
@@ -198,6 +264,10 @@ bool database::_push_block(const signed_block& new_block)
 { try {
    uint32_t skip = get_node_properties().skip_flags;
    const auto now = fc::time_point::now().sec_since_epoch();
+   // the block database batches its writes; make sure irreversible blocks reach the disk
+   auto flush_irreversible = [&]() {
+      _block_id_to_block.flush_irreversible( get_dynamic_global_properties().last_irreversible_block_num );
+   };
 
    if( _fork_db.head() && new_block.timestamp.sec_since_epoch() > now - 86400 )
    {
@@ -271,6 +341,7 @@ bool database::_push_block(const signed_block& new_block)
                   throw *except;
                }
          }
+         flush_irreversible();
          return true;
       }
       else return false;
@@ -288,6 +359,7 @@ bool database::_push_block(const signed_block& new_block)
       _fork_db.remove(new_block.id());
       throw;
    }
+   flush_irreversible();
 
    return false;
 } FC_CAPTURE_AND_RETHROW( (new_block) ) }
@@ -802,7 +874,7 @@ processed_transaction database::_apply_transaction(const signed_transaction& trx
       auto get_active = [this]( account_id_type id ) { return &id(*this).active; };
       auto get_owner  = [this]( account_id_type id ) { return &id(*this).owner;  };
       auto get_custom = [this]( account_id_type id, const operation& op ) {
-         return get_account_custom_authorities(id, op);
+         return get_cached_account_custom_authorities(id, op);
       };
       trx.verify_authority( chain_id, get_active, get_owner, get_custom,
                             MUST_IGNORE_CUSTOM_OP_REQD_AUTHS(head_block_time()),
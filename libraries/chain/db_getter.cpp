@@ -184,6 +184,15 @@ vector<authority> database::get_account_custom_authorities(account_id_type accou
    return custom_auths;
 }
 
+const vector<authority>& database::get_cached_account_custom_authorities(account_id_type account, const operation& op)
+{
+   const time_point_sec now = head_block_time();
+   const vector<authority>* cached = _custom_authority_cache.find(account, op.which(), now);
+   if( cached != nullptr )
+      return *cached;
+   return _custom_authority_cache.insert(account, op.which(), now, get_account_custom_authorities(account, op));
+}
+
 bool database::item_locked(const nft_id_type &item) const
 {
    const auto &offer_idx = get_index_type<offer_index>();
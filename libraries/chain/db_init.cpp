@@ -349,15 +349,17 @@ void database::initialize_indexes()
    add_index< primary_index<betting_market_rules_object_index > >();
    add_index< primary_index<betting_market_group_object_index > >();
    add_index< primary_index<betting_market_object_index > >();
-   add_index< primary_index<bet_object_index > >();
+   auto bet_index = add_index< primary_index<bet_object_index > >();
+   bet_index->add_secondary_index<delayed_bet_index>();
 
-   add_index< primary_index<tournament_index> >();
+   auto tournament_idx = add_index< primary_index<tournament_index> >();
+   tournament_idx->add_secondary_index<pending_tournament_index>();
    auto tournament_details_idx = add_index< primary_index<tournament_details_index> >();
    tournament_details_idx->add_secondary_index<tournament_players_index>();
    add_index< primary_index<match_index> >();
    add_index< primary_index<game_index> >();
-   add_index< primary_index<custom_permission_index> >();
-   add_index< primary_index<custom_account_authority_index> >();
+   add_index< primary_index<custom_permission_index> >()->add_secondary_index<custom_authority_cache::invalidator>( _custom_authority_cache );
+   add_index< primary_index<custom_account_authority_index> >()->add_secondary_index<custom_authority_cache::invalidator>( _custom_authority_cache );
    auto offer_idx = add_index< primary_index<offer_index> >();
    offer_idx->add_secondary_index<offer_item_index>();
 
@@ -378,6 +380,7 @@ void database::initialize_indexes()
 
    auto bal_idx = add_index< primary_index<account_balance_index          > >();
    bal_idx->add_secondary_index<balances_by_account_index>();
+   bal_idx->add_secondary_index<holders_by_asset_index>();
 
    add_index< primary_index<asset_bitasset_data_index,                 13 > >(); // 8192
    add_index< primary_index<asset_dividend_data_object_index              > >();
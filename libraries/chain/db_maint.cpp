@@ -49,6 +49,8 @@
 #include <graphene/chain/worker_object.hpp>
 #include <graphene/chain/custom_account_authority_object.hpp>
 
+#include <graphene/db/thread_pool.hpp>
+
 #define USE_VESTING_OBJECT_BY_ASSET_BALANCE_INDEX // vesting_balance_object by_asset_balance index needed
 
 namespace graphene { namespace chain {
@@ -104,7 +106,7 @@ vector<std::reference_wrapper<const son_object>> database::sort_votable_objects<
 }
 
 template<class Type>
-void database::perform_account_maintenance(Type tally_helper)
+void database::perform_account_maintenance(Type& tally_helper)
 {
    const auto& bal_idx = get_index_type< account_balance_index >().indices().get< by_maintenance_flag >();
    if( bal_idx.begin() != bal_idx.end() )
@@ -1356,7 +1358,7 @@ void schedule_pending_dividend_balances(database& db,
 { try {
    dlog("Processing dividend payments for dividend holder asset type ${holder_asset} at time ${t}",
         ("holder_asset", dividend_holder_asset_obj.symbol)("t", db.head_block_time()));
-   auto balance_by_acc_index = db.get_index_type< primary_index< account_balance_index > >().get_secondary_index< balances_by_account_index >();
+   const auto& balance_by_acc_index = db.get_index_type< primary_index< account_balance_index > >().get_secondary_index< balances_by_account_index >();
    auto current_distribution_account_balance_range =
       //balance_index.indices().get<by_account_asset>().equal_range(boost::make_tuple(dividend_data.dividend_distribution_account));
       balance_by_acc_index.get_account_balances(dividend_data.dividend_distribution_account);
@@ -1382,44 +1384,76 @@ void schedule_pending_dividend_balances(database& db,
       balance_type = vesting_balance_type::gpos;
 
    uint32_t holder_account_count = 0;
+   // the fee, in BTS, for distributing each asset in the account
+   uint64_t total_fee_per_asset_in_core = distribution_base_fee;
+   // when we pay out the dividends to the holders, we need to know the total balance of the dividend asset in all
+   // accounts other than the distribution account (it would be silly to distribute dividends back to
+   // the distribution account)
+   share_type total_balance_of_dividend_asset;
 
 #ifdef USE_VESTING_OBJECT_BY_ASSET_BALANCE_INDEX
-   // get only once a collection of accounts that hold nonzero vesting balances of the dividend asset
    auto vesting_balances_begin =
       vesting_index.indices().get<by_asset_balance>().lower_bound(boost::make_tuple(dividend_holder_asset_obj.id, balance_type));
    auto vesting_balances_end =
       vesting_index.indices().get<by_asset_balance>().upper_bound(boost::make_tuple(dividend_holder_asset_obj.id, balance_type, share_type()));
+#endif
 
-   for (const vesting_balance_object& vesting_balance_obj : boost::make_iterator_range(vesting_balances_begin, vesting_balances_end))
-   {
-        vesting_amounts[vesting_balance_obj.owner] += vesting_balance_obj.balance.amount;
-        ++holder_account_count;
-        dlog("Vesting balance for account: ${owner}, amount: ${amount}",
-             ("owner", vesting_balance_obj.owner(db).name)
-             ("amount", vesting_balance_obj.balance.amount));
-   }
+   // The holders are only needed when the balance of a payout asset has changed, which in most
+   // maintenance intervals it hasn't, so they are gathered the first time that happens.
+   bool holders_gathered = false;
+   auto gather_holders = [&]() {
+      holders_gathered = true;
+#ifdef USE_VESTING_OBJECT_BY_ASSET_BALANCE_INDEX
+      // get only once a collection of accounts that hold nonzero vesting balances of the dividend asset
+      for (const vesting_balance_object& vesting_balance_obj : boost::make_iterator_range(vesting_balances_begin, vesting_balances_end))
+      {
+           vesting_amounts[vesting_balance_obj.owner] += vesting_balance_obj.balance.amount;
+           ++holder_account_count;
+           dlog("Vesting balance for account: ${owner}, amount: ${amount}",
+                ("owner", vesting_balance_obj.owner(db).name)
+                ("amount", vesting_balance_obj.balance.amount));
+      }
 #else
-   // get only once a collection of accounts that hold nonzero vesting balances of the dividend asset
-   const auto& vesting_balances = vesting_index.indices().get<by_id>();
-   for (const vesting_balance_object& vesting_balance_obj : vesting_balances)
-   {
-        if (vesting_balance_obj.balance.asset_id == dividend_holder_asset_obj.id && vesting_balance_obj.balance.amount &&
-        vesting_balance_object.balance_type == balance_type)
-        {
-            vesting_amounts[vesting_balance_obj.owner] += vesting_balance_obj.balance.amount;
-            ++gpos_holder_account_count;
-            dlog("Vesting balance for account: ${owner}, amount: ${amount}",
-                 ("owner", vesting_balance_obj.owner(db).name)
-                 ("amount", vesting_balance_obj.balance.amount));
-        }
-   }
+      // get only once a collection of accounts that hold nonzero vesting balances of the dividend asset
+      const auto& vesting_balances = vesting_index.indices().get<by_id>();
+      for (const vesting_balance_object& vesting_balance_obj : vesting_balances)
+      {
+           if (vesting_balance_obj.balance.asset_id == dividend_holder_asset_obj.id && vesting_balance_obj.balance.amount &&
+           vesting_balance_object.balance_type == balance_type)
+           {
+               vesting_amounts[vesting_balance_obj.owner] += vesting_balance_obj.balance.amount;
+               ++gpos_holder_account_count;
+               dlog("Vesting balance for account: ${owner}, amount: ${amount}",
+                    ("owner", vesting_balance_obj.owner(db).name)
+                    ("amount", vesting_balance_obj.balance.amount));
+           }
+      }
 #endif
 
+      if(db.head_block_time() < HARDFORK_GPOS_TIME)
+         holder_account_count = std::distance(holder_balances_begin, holder_balances_end);
+      total_fee_per_asset_in_core = distribution_base_fee + holder_account_count * (uint64_t)distribution_fee_per_holder;
+
+      if(db.head_block_time() >= HARDFORK_GPOS_TIME && dividend_holder_asset_obj.symbol == GRAPHENE_SYMBOL) { // only core
+         for (const vesting_balance_object &holder_balance_object : boost::make_iterator_range(vesting_balances_begin,
+                                                                                               vesting_balances_end))
+            if (holder_balance_object.owner != dividend_data.dividend_distribution_account) {
+               total_balance_of_dividend_asset += holder_balance_object.balance.amount;
+            }
+      }
+      else {
+         for (const account_balance_object &holder_balance_object : boost::make_iterator_range(holder_balances_begin,
+                                                                                               holder_balances_end))
+            if (holder_balance_object.owner != dividend_data.dividend_distribution_account) {
+               total_balance_of_dividend_asset += holder_balance_object.balance;
+               auto itr = vesting_amounts.find(holder_balance_object.owner);
+               if (itr != vesting_amounts.end())
+                  total_balance_of_dividend_asset += itr->second;
+            }
+      }
+   };
+
    auto current_distribution_account_balance_iter = current_distribution_account_balance_range.begin();
-   if(db.head_block_time() < HARDFORK_GPOS_TIME)
-      holder_account_count = std::distance(holder_balances_begin, holder_balances_end);
-   // the fee, in BTS, for distributing each asset in the account
-   uint64_t total_fee_per_asset_in_core = distribution_base_fee + holder_account_count * (uint64_t)distribution_fee_per_holder;
 
    //auto current_distribution_account_balance_iter = current_distribution_account_balance_range.first;
    auto previous_distribution_account_balance_iter = previous_distribution_account_balance_range.first;
@@ -1427,27 +1461,6 @@ void schedule_pending_dividend_balances(database& db,
         ("current", (int64_t)std::distance(current_distribution_account_balance_range.begin(), current_distribution_account_balance_range.end()))
         ("previous", (int64_t)std::distance(previous_distribution_account_balance_range.first, previous_distribution_account_balance_range.second)));
 
-   // when we pay out the dividends to the holders, we need to know the total balance of the dividend asset in all
-   // accounts other than the distribution account (it would be silly to distribute dividends back to
-   // the distribution account)
-   share_type total_balance_of_dividend_asset;
-   if(db.head_block_time() >= HARDFORK_GPOS_TIME && dividend_holder_asset_obj.symbol == GRAPHENE_SYMBOL) { // only core
-      for (const vesting_balance_object &holder_balance_object : boost::make_iterator_range(vesting_balances_begin,
-                                                                                            vesting_balances_end))
-         if (holder_balance_object.owner != dividend_data.dividend_distribution_account) {
-            total_balance_of_dividend_asset += holder_balance_object.balance.amount;
-         }
-   }
-   else {
-      for (const account_balance_object &holder_balance_object : boost::make_iterator_range(holder_balances_begin,
-                                                                                            holder_balances_end))
-         if (holder_balance_object.owner != dividend_data.dividend_distribution_account) {
-            total_balance_of_dividend_asset += holder_balance_object.balance;
-            auto itr = vesting_amounts.find(holder_balance_object.owner);
-            if (itr != vesting_amounts.end())
-               total_balance_of_dividend_asset += itr->second;
-         }
-   }
    // loop through all of the assets currently or previously held in the distribution account
    while (current_distribution_account_balance_iter != current_distribution_account_balance_range.end() ||
           previous_distribution_account_balance_iter != previous_distribution_account_balance_range.second)
@@ -1485,6 +1498,8 @@ void schedule_pending_dividend_balances(database& db,
          }
 
          share_type delta_balance = current_balance - previous_balance;
+         if (delta_balance != 0 && !holders_gathered)
+            gather_holders();
 
          // Next, figure out if we want to share this out -- if the amount added to the distribution
          // account since last payout is too small, we won't bother.
@@ -1572,12 +1587,18 @@ void schedule_pending_dividend_balances(database& db,
                share_type remaining_amount_to_distribute = delta_balance;
 
                if(db.head_block_time() >= HARDFORK_GPOS_TIME && dividend_holder_asset_obj.symbol == GRAPHENE_SYMBOL) { // core only
+                  flat_map<account_id_type, double> vesting_factors;
                   // credit each account with their portion, don't send any back to the dividend distribution account
                   for (const vesting_balance_object &holder_balance_object : boost::make_iterator_range(
                         vesting_balances_begin, vesting_balances_end)) {
                      if (holder_balance_object.owner == dividend_data.dividend_distribution_account) continue;
 
-                     auto vesting_factor = db.calculate_vesting_factor(holder_balance_object.owner(db));
+                     // an account may have several GPOS balances, its vesting factor is the same for all of them
+                     auto vesting_factor_iter = vesting_factors.find(holder_balance_object.owner);
+                     if (vesting_factor_iter == vesting_factors.end())
+                        vesting_factor_iter = vesting_factors.emplace(holder_balance_object.owner,
+                                                                      db.calculate_vesting_factor(holder_balance_object.owner(db))).first;
+                     auto vesting_factor = vesting_factor_iter->second;
 
                      auto holder_balance = holder_balance_object.balance;
 
@@ -1633,11 +1654,13 @@ void schedule_pending_dividend_balances(database& db,
                                                                      dividend_holder_asset_obj.id);
                   }
                }
+#ifndef NDEBUG
                for (const auto& pending_payout : pending_payout_balance_index.indices())
                   if (pending_payout.pending_balance.value)
                       dlog("Pending payout: ${account_name}   ->   ${amount}",
                            ("account_name", pending_payout.owner(db).name)
                            ("amount", asset(pending_payout.pending_balance, pending_payout.dividend_payout_asset_type)));
+#endif
                dlog("Remaining balance not paid out: ${amount}",
                     ("amount", asset(remaining_amount_to_distribute, payout_asset_type)));
 
@@ -1767,8 +1790,9 @@ void process_dividend_assets(database& db)
                std::map<asset_id_type, share_type> amounts_paid_out_by_asset;
 
                auto pending_payouts_range =
-                  pending_payout_balance_index.indices().get<by_dividend_account_payout>().equal_range(boost::make_tuple(dividend_holder_asset_obj.id));
-               // the pending_payouts_range is all payouts for this dividend asset, sorted by the holder's account
+                  pending_payout_balance_index.indices().get<by_dividend_account_payout>().equal_range(boost::make_tuple(dividend_holder_asset_obj.id, true));
+               // the pending_payouts_range is all nonzero payouts for this dividend asset, sorted by the holder's account.
+               // The holders whose balances were paid out before are skipped without being visited.
                // we iterate in this order so we can build up a list of payouts for each account to put in the
                // virtual op
                vector<asset> payouts_for_this_holder;
@@ -1790,6 +1814,8 @@ void process_dividend_assets(database& db)
                for (auto pending_balance_object_iter = pending_payouts_range.first; pending_balance_object_iter != pending_payouts_range.second; )
                {
                   const pending_dividend_payout_balance_for_holder_object& pending_balance_object = *pending_balance_object_iter;
+                  // paying out moves the object out of the range, so step past it first
+                  ++pending_balance_object_iter;
 
                   if (last_holder_account_id && *last_holder_account_id != pending_balance_object.owner && payouts_for_this_holder.size())
                   {
@@ -1823,8 +1849,6 @@ void process_dividend_assets(database& db)
                         pending_balance.pending_balance = 0;
                      });
                   }
-
-                  ++pending_balance_object_iter;
                }
                // we will always be left with the last holder's data, generate the virtual op for it now.
                if (last_holder_account_id && payouts_for_this_holder.size())
@@ -1970,18 +1994,52 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
    rolling_period_start(*this);
 
    struct vote_tally_helper {
+      /// The votes counted by one tally, either all accounts or one shard of them
+      struct tally_buffers
+      {
+         vector<uint64_t> vote_tally;
+         vector<uint64_t> witness_count_histogram;
+         vector<uint64_t> committee_count_histogram;
+         vector<uint64_t> son_count_histogram;
+         uint64_t         total_voting_stake = 0;
+
+         explicit tally_buffers(const global_property_object& props)
+            : vote_tally(props.next_available_vote_id),
+              witness_count_histogram(props.parameters.maximum_witness_count / 2 + 1),
+              committee_count_histogram(props.parameters.maximum_committee_count / 2 + 1),
+              son_count_histogram(props.parameters.maximum_son_count() / 2 + 1)
+         {}
+
+         void add( const tally_buffers& other )
+         {
+            for( size_t i = 0; i < vote_tally.size(); ++i )
+               vote_tally[i] += other.vote_tally[i];
+            for( size_t i = 0; i < witness_count_histogram.size(); ++i )
+               witness_count_histogram[i] += other.witness_count_histogram[i];
+            for( size_t i = 0; i < committee_count_histogram.size(); ++i )
+               committee_count_histogram[i] += other.committee_count_histogram[i];
+            for( size_t i = 0; i < son_count_histogram.size(); ++i )
+               son_count_histogram[i] += other.son_count_histogram[i];
+            total_voting_stake += other.total_voting_stake;
+         }
+      };
+
       database& d;
       const global_property_object& props;
       std::map<account_id_type, share_type> vesting_amounts;
+      tally_buffers totals;
+      /**
+       * Once the GPOS transition is over, an account's voting stake only depends on its GPOS vesting balances,
+       * its last vote time and its options, none of which are touched by fee processing. The tally is then
+       * deferred until all fees are processed and runs in parallel over shards of the accounts.
+       */
+      bool defer_tally;
+      vector<const account_object*> deferred_accounts;
 
       vote_tally_helper(database& d, const global_property_object& gpo)
-         : d(d), props(gpo)
+         : d(d), props(gpo), totals(gpo),
+           defer_tally(d.head_block_time() >= (HARDFORK_GPOS_TIME + gpo.parameters.gpos_subperiod()/2))
       {
-         d._vote_tally_buffer.resize(props.next_available_vote_id);
-         d._witness_count_histogram_buffer.resize(props.parameters.maximum_witness_count / 2 + 1);
-         d._committee_count_histogram_buffer.resize(props.parameters.maximum_committee_count / 2 + 1);
-         d._son_count_histogram_buffer.resize(props.parameters.maximum_son_count() / 2 + 1);
-         d._total_voting_stake = 0;
 
          auto balance_type = vesting_balance_type::normal;
          if(d.head_block_time() >= HARDFORK_GPOS_TIME)
@@ -2016,6 +2074,43 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
       }
 
       void operator()( const account_object& stake_account, const account_statistics_object& stats )
+      {
+         if( defer_tally )
+            deferred_accounts.push_back( &stake_account );
+         else
+            tally( stake_account, totals );
+      }
+
+      /// Counts the deferred accounts and stores the totals in the database's buffers
+      void finish()
+      {
+         if( !deferred_accounts.empty() )
+         {
+            // small shards are not worth the extra buffers
+            const size_t min_accounts_per_shard = std::max<size_t>( 1, d.get_node_properties().min_accounts_per_vote_tally_shard );
+            const size_t shard_count = std::max<size_t>( 1, std::min<size_t>( db::thread_pool::shared().size() + 1,
+                                                         deferred_accounts.size() / min_accounts_per_shard ) );
+            const size_t shard_size = ( deferred_accounts.size() + shard_count - 1 ) / shard_count;
+            vector<tally_buffers> shards( shard_count, tally_buffers( props ) );
+            db::thread_pool::shared().run_for_each( shard_count, [this,&shards,shard_size]( size_t shard ) {
+               const size_t end = std::min( deferred_accounts.size(), ( shard + 1 ) * shard_size );
+               for( size_t i = shard * shard_size; i < end; ++i )
+                  tally( *deferred_accounts[i], shards[shard] );
+            });
+            // the sums are exact, so adding the shards up in order gives the same result as the sequential tally
+            for( const tally_buffers& shard : shards )
+               totals.add( shard );
+         }
+
+         d._vote_tally_buffer = std::move( totals.vote_tally );
+         d._witness_count_histogram_buffer = std::move( totals.witness_count_histogram );
+         d._committee_count_histogram_buffer = std::move( totals.committee_count_histogram );
+         d._son_count_histogram_buffer = std::move( totals.son_count_histogram );
+         d._total_voting_stake = totals.total_voting_stake;
+      }
+
+      /// Only reads the database, so that shards of the accounts can be tallied in parallel
+      void tally( const account_object& stake_account, tally_buffers& out )const
       {
          if( props.parameters.count_non_member_votes || stake_account.is_member(d.head_block_time()) )
          {
@@ -2066,60 +2161,61 @@ void database::perform_chain_maintenance(const signed_block& next_block, const g
             {
                uint32_t offset = id.instance();
                // if they somehow managed to specify an illegal offset, ignore it.
-               if( offset < d._vote_tally_buffer.size() )
-                  d._vote_tally_buffer[offset] += voting_stake;
+               if( offset < out.vote_tally.size() )
+                  out.vote_tally[offset] += voting_stake;
             }
 
             if( opinion_account.options.num_witness <= props.parameters.maximum_witness_count )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_witness/2),
-                                          d._witness_count_histogram_buffer.size() - 1);
+                                          out.witness_count_histogram.size() - 1);
                // votes for a number greater than maximum_witness_count
                // are turned into votes for maximum_witness_count.
                //
                // in particular, this takes care of the case where a
                // member was voting for a high number, then the
                // parameter was lowered.
-               d._witness_count_histogram_buffer[offset] += voting_stake;
+               out.witness_count_histogram[offset] += voting_stake;
             }
             if( opinion_account.options.num_committee <= props.parameters.maximum_committee_count )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_committee/2),
-                                          d._committee_count_histogram_buffer.size() - 1);
+                                          out.committee_count_histogram.size() - 1);
                // votes for a number greater than maximum_committee_count
                // are turned into votes for maximum_committee_count.
                //
                // same rationale as for witnesses
-               d._committee_count_histogram_buffer[offset] += voting_stake;
+               out.committee_count_histogram[offset] += voting_stake;
             }
             if( opinion_account.options.num_son <= props.parameters.maximum_son_count() )
             {
                uint16_t offset = std::min(size_t(opinion_account.options.num_son/2),
-                                          d._son_count_histogram_buffer.size() - 1);
+                                          out.son_count_histogram.size() - 1);
                // votes for a number greater than maximum_son_count
                // are turned into votes for maximum_son_count.
                //
                // in particular, this takes care of the case where a
                // member was voting for a high number, then the
                // parameter was lowered.
-               d._son_count_histogram_buffer[offset] += voting_stake;
+               out.son_count_histogram[offset] += voting_stake;
             }
 
-            d._total_voting_stake += voting_stake;
+            out.total_voting_stake += voting_stake;
          }
       }
    } tally_helper(*this, gpo);
    
    perform_account_maintenance( tally_helper );
+   tally_helper.finish();
    struct clear_canary {
       clear_canary(vector<uint64_t>& target): target(target){}
       ~clear_canary() { target.clear(); }
    private:
       vector<uint64_t>& target;
    };
-   clear_canary a(_witness_count_histogram_buffer),
-                b(_committee_count_histogram_buffer),
-                d(_son_count_histogram_buffer),
+   // the witness and committee count histograms are small, they are kept until the next maintenance
+   // so that the result of the tally can be inspected
+   clear_canary d(_son_count_histogram_buffer),
                 c(_vote_tally_buffer);
 
    perform_son_tasks();
@@ -31,10 +31,15 @@
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/io/raw.hpp>
 
+#include <atomic>
+#include <condition_variable>
 #include <fstream>
 #include <functional>
 #include <iostream>
+#include <mutex>
+#include <thread>
 
 namespace graphene { namespace chain {
 
@@ -94,6 +99,135 @@ public:
     }
 };
 
+/**
+ * Reads, unpacks and checks the blocks of a replay on its own threads, ahead of
+ * the loop that applies them.  Blocks are handed out strictly in order by next().
+ * Nothing may be written to the block_database while the reader is alive.
+ */
+class replay_block_reader
+{
+public:
+    struct replay_block
+    {
+        optional<signed_block> block;
+        /// the transaction merkle root has been verified on the reader thread
+        bool                   merkle_checked = false;
+    };
+
+    replay_block_reader( const block_database& blocks, uint32_t first, uint32_t last, uint32_t num_threads ) :
+        _blocks(blocks),
+        _last(last),
+        _next(first),
+        _slots(BLOCKS_AHEAD)
+    {
+        for( uint32_t i = 0; i < num_threads; ++i )
+            _threads.emplace_back( [this,first,i,num_threads](){ read_loop( first + i, num_threads ); } );
+    }
+
+    ~replay_block_reader()
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _stopping = true;
+        }
+        _cv.notify_all();
+        for( auto& thread : _threads )
+            thread.join();
+    }
+
+    /// @return the next block, waiting for the reader threads if necessary
+    replay_block next()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        slot& next_slot = _slots[_next % _slots.size()];
+        const auto wait_start = fc::time_point::now();
+        _cv.wait( lock, [&next_slot](){ return next_slot.ready; } );
+        _wait_time += fc::time_point::now() - wait_start;
+        replay_block result = std::move( next_slot.data );
+        next_slot = slot();
+        ++_next;
+        lock.unlock();
+        _cv.notify_all();
+        return result;
+    }
+
+    /// time spent reading and decoding, summed over all reader threads
+    fc::microseconds read_time()const   { return fc::microseconds( _read_time ); }
+    fc::microseconds decode_time()const { return fc::microseconds( _decode_time ); }
+    /// time next() spent waiting for blocks that were not ready yet
+    fc::microseconds wait_time()const   { return _wait_time; }
+    uint32_t thread_count()const        { return _threads.size(); }
+
+private:
+    static const size_t BLOCKS_AHEAD = 256;
+
+    struct slot
+    {
+        bool         ready = false;
+        replay_block data;
+    };
+
+    void read_loop( uint32_t start, uint32_t stride )
+    {
+        for( uint32_t num = start; num <= _last; num += stride )
+        {
+            {
+                // wait until the slot of this block has been consumed
+                std::unique_lock<std::mutex> lock(_mutex);
+                _cv.wait( lock, [this,num](){ return _stopping || num < _next + _slots.size(); } );
+                if( _stopping )
+                    return;
+            }
+
+            replay_block result;
+            const auto read_start = fc::time_point::now();
+            optional<vector<char>> data = _blocks.fetch_serialized_by_number( num );
+            const auto decode_start = fc::time_point::now();
+            if( data.valid() )
+            {
+                try
+                {
+                    signed_block block = fc::raw::unpack<signed_block>( *data );
+                    if( block.id() == _blocks.fetch_block_id( num ) )
+                    {
+                        result.merkle_checked = ( block.transaction_merkle_root == block.calculate_merkle_root() );
+                        result.block = std::move( block );
+                    }
+                }
+                catch( const fc::exception& )
+                {
+                }
+                catch( const std::exception& )
+                {
+                }
+            }
+            const auto decode_end = fc::time_point::now();
+            _read_time += ( decode_start - read_start ).count();
+            _decode_time += ( decode_end - decode_start ).count();
+
+            {
+                std::unique_lock<std::mutex> lock(_mutex);
+                slot& block_slot = _slots[num % _slots.size()];
+                block_slot.data = std::move( result );
+                block_slot.ready = true;
+            }
+            _cv.notify_all();
+        }
+    }
+
+    const block_database&    _blocks;
+    const uint32_t           _last;
+    uint32_t                 _next;  ///< number of the block next() returns
+    vector<slot>             _slots; ///< ring buffer, block n goes to _slots[n % _slots.size()]
+    std::mutex               _mutex;
+    std::condition_variable  _cv;
+    bool                     _stopping = false;
+    std::atomic<int64_t>     _read_time{0};
+    std::atomic<int64_t>     _decode_time{0};
+    fc::microseconds         _wait_time;
+    vector<std::thread>      _threads;
+};
+
 void database::reindex( fc::path data_dir )
 { try {
    auto last_block = _block_id_to_block.last();
@@ -121,7 +255,21 @@ void database::reindex( fc::path data_dir )
    {
        undo.disable();
    }
-   for( uint32_t i = head_block_num() + 1; i <= last_block_num; ++i )
+
+   // Blocks before undo_point are only applied, nothing is written to the block database
+   // while they are replayed, so they can be read and decoded ahead on other threads.
+   const uint32_t first_block_num = head_block_num() + 1;
+   const uint32_t prefetch_end = _slow_replays ? first_block_num : std::max( first_block_num, undo_point );
+   std::unique_ptr<replay_block_reader> reader;
+   if( prefetch_end > first_block_num )
+   {
+      const uint32_t reader_threads = std::max( 1u, std::min( 4u, std::thread::hardware_concurrency() / 2 ) );
+      reader.reset( new replay_block_reader( _block_id_to_block, first_block_num, prefetch_end - 1, reader_threads ) );
+   }
+   fc::microseconds fetch_time;
+   fc::microseconds apply_time;
+
+   for( uint32_t i = first_block_num; i <= last_block_num; ++i )
    {
       if( i % 10000 == 0 ) std::cerr << "   " << double(i*100)/last_block_num << "%   "<<i << " of " <<last_block_num<<"   \n";
       if( i == flush_point )
@@ -130,9 +278,24 @@ void database::reindex( fc::path data_dir )
          flush();
          ilog( "Done" );
       }
-      fc::optional< signed_block > block = _block_id_to_block.fetch_by_number(i);
+      fc::optional< signed_block > block;
+      uint32_t merkle_skip = skip_nothing;
+      if( i < prefetch_end )
+      {
+         replay_block_reader::replay_block next = reader->next();
+         block = std::move( next.block );
+         if( next.merkle_checked )
+            merkle_skip = skip_merkle_check;
+      }
+      else
+      {
+         const auto fetch_start = fc::time_point::now();
+         block = _block_id_to_block.fetch_by_number(i);
+         fetch_time += fc::time_point::now() - fetch_start;
+      }
       if( !block.valid() )
       {
+         reader.reset(); // must not read while blocks are removed below
          wlog( "Reindexing terminated due to gap:  Block ${i} does not exist!", ("i", i) );
          uint32_t dropped_count = 0;
          while( true )
@@ -150,6 +313,7 @@ void database::reindex( fc::path data_dir )
          wlog( "Dropped ${n} blocks from after the gap", ("n", dropped_count) );
          break;
       }
+      const auto apply_start = fc::time_point::now();
       if( i < undo_point && !_slow_replays)
       {
          apply_block(*block, skip_witness_signature |
@@ -157,7 +321,8 @@ void database::reindex( fc::path data_dir )
                              skip_transaction_dupe_check |
                              skip_tapos_check |
                              skip_witness_schedule_check |
-                             skip_authority_check);
+                             skip_authority_check |
+                             merkle_skip);
       }
       else
       {
@@ -167,12 +332,26 @@ void database::reindex( fc::path data_dir )
                             skip_transaction_dupe_check |
                             skip_tapos_check |
                             skip_witness_schedule_check |
-                            skip_authority_check);
+                            skip_authority_check |
+                            merkle_skip);
       }
+      apply_time += fc::time_point::now() - apply_start;
    }
    undo.enable();
    auto end = fc::time_point::now();
    ilog( "Done reindexing, elapsed time: ${t} sec", ("t",double((end-start).count())/1000000.0 ) );
+   if( _replay_stats )
+   {
+      auto seconds = []( const fc::microseconds& t ) { return double(t.count())/1000000.0; };
+      ilog( "Replay stats: apply ${a} sec, read ${r} sec and decode ${d} sec on ${n} reader threads "
+            "(apply loop waited ${w} sec for them), synchronous fetch ${f} sec",
+            ("a",seconds(apply_time))
+            ("r",seconds(reader ? reader->read_time() : fc::microseconds()))
+            ("d",seconds(reader ? reader->decode_time() : fc::microseconds()))
+            ("n",reader ? reader->thread_count() : 0)
+            ("w",seconds(reader ? reader->wait_time() : fc::microseconds()))
+            ("f",seconds(fetch_time)) );
+   }
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
 
 void database::wipe(const fc::path& data_dir, bool include_blocks)
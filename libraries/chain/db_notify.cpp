@@ -610,14 +610,14 @@ void database::notify_changed_objects()
       {
         vector<object_id_type> new_ids;  new_ids.reserve(head_undo.new_ids.size());
         flat_set<account_id_type> new_accounts_impacted;
-        for( const auto& item : head_undo.new_ids )
+        head_undo.new_ids.for_each( [&]( object_id_type id, const graphene::db::no_value& )
         {
-          new_ids.push_back(item);
-          auto obj = find_object(item);
+          new_ids.push_back(id);
+          auto obj = find_object(id);
           if(obj != nullptr)
             get_relevant_accounts(obj, new_accounts_impacted,
                                   MUST_IGNORE_CUSTOM_OP_REQD_AUTHS(chain_time));
-        }
+        });
 
         GRAPHENE_TRY_NOTIFY( new_objects, new_ids, new_accounts_impacted)
       }
@@ -627,12 +627,12 @@ void database::notify_changed_objects()
       {
         vector<object_id_type> changed_ids;  changed_ids.reserve(head_undo.old_values.size());
         flat_set<account_id_type> changed_accounts_impacted;
-        for( const auto& item : head_undo.old_values )
+        head_undo.old_values.for_each( [&]( object_id_type id, const object* old_value )
         {
-          changed_ids.push_back(item.first);
-          get_relevant_accounts(item.second.get(), changed_accounts_impacted,
+          changed_ids.push_back(id);
+          get_relevant_accounts(old_value, changed_accounts_impacted,
                                 MUST_IGNORE_CUSTOM_OP_REQD_AUTHS(chain_time));
-        }
+        });
 
         GRAPHENE_TRY_NOTIFY( changed_objects, changed_ids, changed_accounts_impacted)
       }
@@ -643,14 +643,13 @@ void database::notify_changed_objects()
         vector<object_id_type> removed_ids; removed_ids.reserve( head_undo.removed.size() );
         vector<const object*> removed; removed.reserve( head_undo.removed.size() );
         flat_set<account_id_type> removed_accounts_impacted;
-        for( const auto& item : head_undo.removed )
+        head_undo.removed.for_each( [&]( object_id_type id, const object* obj )
         {
-          removed_ids.emplace_back( item.first );
-          auto obj = item.second.get();
+          removed_ids.emplace_back( id );
           removed.emplace_back( obj );
           get_relevant_accounts(obj, removed_accounts_impacted,
                                 MUST_IGNORE_CUSTOM_OP_REQD_AUTHS(chain_time));
-        }
+        });
 
         GRAPHENE_TRY_NOTIFY( removed_objects, removed_ids, removed, removed_accounts_impacted)
       }
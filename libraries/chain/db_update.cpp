@@ -166,44 +166,27 @@ void database::place_delayed_bets()
    // If any bets have been placed during live betting where bets are delayed for a few seconds, see if there are
    // any bets whose delays have expired.
 
-   // Delayed bets are sorted to the beginning of the order book, so if there are any bets that need placing, 
-   // they're right at the front of the book
-   const auto& bet_odds_idx = get_index_type<bet_object_index>().indices().get<by_odds>();
-   auto iter = bet_odds_idx.begin();
-
-   // we use an awkward looping mechanism here because there's a case where we are processing the
-   // last delayed bet before the "real" order book starts and `iter` was pointing at the first 
-   // real order.  The place_bet() call can cause the that real order to be deleted, so we need
-   // to decide whether this is the last delayed bet before `place_bet` is called.
-   bool last = iter == bet_odds_idx.end() || 
-               !iter->end_of_delay ||
-               *iter->end_of_delay > head_block_time();
-   while (!last)
+   // it's possible that the betting market was active when the bet was placed,
+   // but has been frozen before the delay expired.  If that's the case here,
+   // don't try to match the bet.  The bets of such markets are skipped as a whole,
+   // so they don't cost anything per bet while the market stays frozen.
+   const auto& delayed_bets = get_index_type< primary_index<bet_object_index> >().get_secondary_index<delayed_bet_index>();
+   const vector<bet_id_type> bets_to_place = delayed_bets.get_bets_due( head_block_time(), [this]( betting_market_id_type market_id ) {
+      return market_id(*this).get_status() != betting_market_status::unresolved;
+   });
+
+   for( const bet_id_type& bet_id : bets_to_place )
    {
-      const bet_object& bet_to_place = *iter;
-      ++iter;
-
-      last = iter == bet_odds_idx.end() || 
-             !iter->end_of_delay ||
-             *iter->end_of_delay > head_block_time();
-
-      // it's possible that the betting market was active when the bet was placed,
-      // but has been frozen before the delay expired.  If that's the case here,
-      // don't try to match the bet.
-      // Since this check happens every block, this could impact performance if a
-      // market with many delayed bets is frozen for a long time.
-      // Our current understanding is that the witnesses will typically cancel all unmatched
-      // bets on frozen markets to avoid this.
-      const betting_market_object& betting_market = bet_to_place.betting_market_id(*this);
-      if (betting_market.get_status() == betting_market_status::unresolved)
-      {
-         modify(bet_to_place, [](bet_object& bet_obj) {
-            // clear the end_of_delay,  which will re-sort the bet into its place in the book
-            bet_obj.end_of_delay.reset();
-         });
+      const bet_object* bet_to_place = find( bet_id );
+      if( !bet_to_place )
+         continue;
 
-         place_bet(bet_to_place);
-      }
+      modify(*bet_to_place, [](bet_object& bet_obj) {
+         // clear the end_of_delay,  which will re-sort the bet into its place in the book
+         bet_obj.end_of_delay.reset();
+      });
+
+      place_bet(*bet_to_place);
    }
 } FC_CAPTURE_AND_RETHROW() }
 
@@ -574,25 +557,15 @@ uint64_t database::get_random_bits( uint64_t bound )
    return _random_number_generator(bound);
 }
 
-void process_finished_games(database& db)
-{
-   //auto& games_index = db.get_index_type<game_index>().indices().get<by_id>();
-}
-
-void process_finished_matches(database& db)
+void process_in_progress_tournaments(database& db, pending_tournament_index& pending_idx)
 {
-}
-
-void process_in_progress_tournaments(database& db)
-{
-   auto& start_time_index = db.get_index_type<tournament_index>().indices().get<by_start_time>();
-   auto start_iter = start_time_index.lower_bound(boost::make_tuple(tournament_state::in_progress));
-   while (start_iter != start_time_index.end() &&
-          start_iter->get_state() == tournament_state::in_progress)
+   // only the tournaments that started or had a match completed since the last block can start new matches
+   for (const tournament_id_type& tournament_id : pending_idx.take_pending_tournaments(db.head_block_num(),
+                                                                                      db.get_dynamic_global_properties().last_irreversible_block_num))
    {
-      auto next_iter = std::next(start_iter);
-      start_iter->check_for_new_matches_to_start(db);
-      start_iter = next_iter;
+      const tournament_object* tournament = db.find(tournament_id);
+      if (tournament && tournament->get_state() == tournament_state::in_progress)
+         tournament->check_for_new_matches_to_start(db);
    }
 }
 
@@ -638,10 +611,6 @@ void start_fully_registered_tournaments(database& db)
    }
 }
 
-void initiate_next_round_of_matches(database& db)
-{
-}
-
 void initiate_next_games(database& db)
 {
    // Next, trigger timeouts on any games which have been waiting too long for commit or
@@ -667,17 +636,11 @@ void initiate_next_games(database& db)
 void database::update_tournaments()
 {
    // Process as follows:
-   // - Process games
-   // - Process matches
    // - Process tournaments
-   // - Process matches
    // - Process games
-   process_finished_games(*this);
-   process_finished_matches(*this);
    cancel_expired_tournaments(*this);
    start_fully_registered_tournaments(*this);
-   process_in_progress_tournaments(*this);
-   initiate_next_round_of_matches(*this);
+   process_in_progress_tournaments(*this, *get_mutable_index_type<primary_index<tournament_index> >().find_secondary_index<pending_tournament_index>());
    initiate_next_games(*this);
 }
 
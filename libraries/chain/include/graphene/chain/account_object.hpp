@@ -26,6 +26,7 @@
 #include <graphene/db/generic_index.hpp>
 #include <graphene/chain/protocol/account.hpp>
 #include <boost/multi_index/composite_key.hpp>
+#include <boost/multi_index/ranked_index.hpp>
 
 namespace graphene { namespace chain {
    class database;
@@ -382,6 +383,7 @@ namespace graphene { namespace chain {
          share_type        pending_balance;
 
          asset get_pending_balance()const { return asset(pending_balance, dividend_payout_asset_type); }
+         bool  has_pending_balance()const { return pending_balance.value != 0; }
          void  adjust_balance(const asset& delta);
    };
 
@@ -410,6 +412,36 @@ namespace graphene { namespace chain {
          std::stack< object_id_type > ids_being_modified;
    };
    
+   /**
+    *  @brief This secondary index will allow fast access to the number of balances of an asset
+    */
+   class holders_by_asset_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void about_to_modify( const object& before ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /** @return the number of balance objects of asset, including empty ones */
+         uint64_t get_balance_count( const asset_id_type& asset )const;
+         /** @return the number of accounts with a nonzero balance of asset */
+         uint64_t get_holder_count( const asset_id_type& asset )const;
+
+      private:
+         struct counts
+         {
+            uint64_t balances = 0;
+            uint64_t holders = 0;
+         };
+
+         counts& counts_of( const asset_id_type& asset );
+
+         /** Indexed by asset instance */
+         vector< counts > asset_counts;
+         std::stack< bool > held_before_modify;
+   };
+
    struct by_asset_balance;
    struct by_maintenance_flag;
    struct by_account_asset;
@@ -430,7 +462,7 @@ namespace graphene { namespace chain {
                member<account_balance_object, asset_id_type, &account_balance_object::asset_type>
             >
          >,
-         ordered_unique< tag<by_asset_balance>,
+         ranked_unique< tag<by_asset_balance>,
             composite_key<
                account_balance_object,
                member<account_balance_object, asset_id_type, &account_balance_object::asset_type>,
@@ -470,7 +502,7 @@ namespace graphene { namespace chain {
    typedef generic_index<account_object, account_multi_index_type> account_index;
 
    struct by_dividend_payout_account{}; // use when calculating pending payouts
-   struct by_dividend_account_payout{}; // use when doing actual payouts
+   struct by_dividend_account_payout{}; // use when doing actual payouts, holders with a pending balance come last
    struct by_account_dividend_payout{}; // use in get_full_accounts()
 
    /**
@@ -492,6 +524,7 @@ namespace graphene { namespace chain {
             composite_key<
                pending_dividend_payout_balance_for_holder_object,
                member<pending_dividend_payout_balance_for_holder_object, asset_id_type, &pending_dividend_payout_balance_for_holder_object::dividend_holder_asset_type>,
+               const_mem_fun<pending_dividend_payout_balance_for_holder_object, bool, &pending_dividend_payout_balance_for_holder_object::has_pending_balance>,
                member<pending_dividend_payout_balance_for_holder_object, account_id_type, &pending_dividend_payout_balance_for_holder_object::owner>,
                member<pending_dividend_payout_balance_for_holder_object, asset_id_type, &pending_dividend_payout_balance_for_holder_object::dividend_payout_asset_type>
             >
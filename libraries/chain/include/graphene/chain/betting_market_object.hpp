@@ -27,6 +27,7 @@
 #include <graphene/db/object.hpp>
 #include <graphene/db/generic_index.hpp>
 #include <graphene/chain/protocol/betting_market.hpp>
+#include <set>
 #include <sstream>
 
 #include <boost/multi_index/composite_key.hpp>
@@ -606,6 +607,38 @@ typedef multi_index_container<
       ordered_unique< tag<by_bettor_and_odds>, identity<bet_object>, compare_bet_by_bettor_then_odds > > > bet_object_multi_index_type;
 typedef generic_index<bet_object, bet_object_multi_index_type> bet_object_index;
 
+/**
+ *  @brief Secondary index of the bets placed during live betting whose delay has not been processed yet,
+ *  by betting market and end of delay
+ *
+ *  Lets database::place_delayed_bets() find the bets whose delay ended without walking the
+ *  delayed bets of markets that were frozen in the meantime.
+ */
+class delayed_bet_index : public secondary_index
+{
+   public:
+      virtual void object_inserted( const object& obj ) override;
+      virtual void object_removed( const object& obj ) override;
+      virtual void about_to_modify( const object& before ) override;
+      virtual void object_modified( const object& after  ) override;
+
+      /**
+       *  @return the delayed bets whose delay ended at or before now, in the order of the by_odds index,
+       *  leaving out the bets on markets for which skip_market returns true
+       */
+      vector<bet_id_type> get_bets_due( fc::time_point_sec now,
+                                        const std::function<bool(betting_market_id_type)>& skip_market )const;
+
+   private:
+      void add( const bet_object& bet );
+      void remove( const bet_object& bet );
+
+      typedef std::map< std::pair<fc::time_point_sec, bet_id_type>, const bet_object* > bets_by_end_of_delay;
+      map< betting_market_id_type, bets_by_end_of_delay >              _bets_by_market;
+      /** the earliest end of delay of each betting market with delayed bets */
+      std::set< std::pair<fc::time_point_sec, betting_market_id_type> > _next_end_of_delay;
+};
+
 struct by_bettor_betting_market{};
 struct by_betting_market_bettor{};
 typedef multi_index_container<
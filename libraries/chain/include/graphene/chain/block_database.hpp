@@ -23,19 +23,56 @@
  */
 #pragma once
 #include <fstream>
+#include <map>
 #include <graphene/chain/protocol/block.hpp>
 
 #include <fc/filesystem.hpp>
+#include <fc/interprocess/file_mapping.hpp>
 
 namespace graphene { namespace chain {
-   class index_entry;
+   /**
+    *  One fixed-size record per block number in the index file.  The record
+    *  is written to disk as-is, so its layout is part of the on-disk format.
+    */
+   struct index_entry
+   {
+      uint64_t      block_pos = 0;
+      uint32_t      block_size = 0;
+      block_id_type block_id;
+   };
 
+   /**
+    *  @class block_database
+    *  @brief Append-only log of irreversible blocks, addressable by number and id
+    *
+    *  Blocks are appended to the "blocks" file and located through the "index"
+    *  file, which holds one index_entry per block number.  Both files are read
+    *  through read-only memory mappings, so lookups do not issue any syscalls
+    *  and block bodies are unpacked directly from the mapped region.
+    *
+    *  Writes are collected in memory and appended to disk in batches of up to
+    *  MAX_PENDING_BYTES, or when flush() or close() is called.  Until then
+    *  they are served from the in-memory batch, and are lost if the process
+    *  dies.  The chain database calls flush_irreversible() after each block,
+    *  which writes the batch once it holds MAX_PENDING_IRREVERSIBLE_BLOCKS
+    *  irreversible blocks, so a crash loses at most that many irreversible
+    *  blocks.  Like the reversible ones, they are fetched from the network
+    *  again on the next start.
+    *
+    *  The const accessors do not modify the database, so they may be called
+    *  from several threads at once, as long as no other member is called at
+    *  the same time.
+    */
    class block_database 
    {
       public:
+         ~block_database();
+
          void open( const fc::path& dbdir );
          bool is_open()const;
          void flush();
+         /** flushes if the oldest pending block is at least MAX_PENDING_IRREVERSIBLE_BLOCKS below the given one */
+         void flush_irreversible( uint32_t last_irreversible_block_num );
          void close();
 
          void store( const block_id_type& id, const signed_block& b );
@@ -45,12 +82,59 @@ namespace graphene { namespace chain {
          block_id_type          fetch_block_id( uint32_t block_num )const;
          optional<signed_block> fetch_optional( const block_id_type& id )const;
          optional<signed_block> fetch_by_number( uint32_t block_num )const;
+         /** @return the block as it is stored, serialized with fc::raw, without checking its id */
+         optional<vector<char>> fetch_serialized_by_number( uint32_t block_num )const;
+         /** @return the block with the given id as it is stored, serialized with fc::raw */
+         optional<vector<char>> fetch_serialized( const block_id_type& id )const;
+         /**
+          *  Blocks first_block_num .. first_block_num + count - 1, located with a single read of the
+          *  index and unpacked in parallel on the shared worker pool.  Entries are empty for block
+          *  numbers that are not stored.
+          */
+         vector<optional<signed_block>> fetch_range( uint32_t first_block_num, uint32_t count )const;
+         /** @return the same range as fetch_range(), serialized with fc::raw as the blocks are stored */
+         vector<optional<vector<char>>> fetch_serialized_range( uint32_t first_block_num, uint32_t count )const;
          optional<signed_block> last()const;
          optional<block_id_type> last_id()const;
+
+         /** pending writes are appended to disk once they exceed this many bytes */
+         static const size_t MAX_PENDING_BYTES = 1024 * 1024;
+         /** irreversible blocks that may be kept in memory only, see flush_irreversible() */
+         static const uint32_t MAX_PENDING_IRREVERSIBLE_BLOCKS = 100;
+
       private:
          optional<index_entry> last_index_entry()const;
+         /** @return false if there is no entry for block_num */
+         bool                  read_index_entry( uint32_t block_num, index_entry& e )const;
+         /** @return count entries starting at first_block_num, the entries of missing blocks have block_size 0 */
+         vector<index_entry>   read_index_range( uint32_t first_block_num, uint32_t count )const;
+         /** @return a pointer to the e.block_size serialized bytes of the block, or nullptr if out of range */
+         const char*           block_data( const index_entry& e )const;
+         optional<signed_block> unpack_block( const index_entry& e )const;
+         /** removes the entries at the end of the index that do not point to a complete block */
+         void truncate_index();
+
+         void write_pending();
+         /** maps the files with their current sizes, must be called whenever a size changes */
+         void map_files();
+         void unmap_files();
+
          fc::path _index_filename;
-         mutable std::fstream _blocks;
-         mutable std::fstream _block_num_to_pos;
+         fc::path _blocks_filename;
+         std::fstream _blocks;
+         std::fstream _block_num_to_pos;
+
+         /** sizes of the files on disk, not including pending writes */
+         uint64_t _index_size = 0;
+         uint64_t _blocks_size = 0;
+
+         std::unique_ptr<fc::file_mapping>  _index_mapping;
+         std::unique_ptr<fc::mapped_region> _index_region;
+         std::unique_ptr<fc::file_mapping>  _blocks_mapping;
+         std::unique_ptr<fc::mapped_region> _blocks_region;
+
+         /** index entries and block bytes that have not been written to disk yet */
+         std::map<uint32_t, index_entry> _pending_index;
+         std::vector<char>               _pending_blocks;
    };
 } }
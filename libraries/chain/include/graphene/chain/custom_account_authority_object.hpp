@@ -1,4 +1,5 @@
 #pragma once
+#include <graphene/chain/protocol/authority.hpp>
 #include <graphene/chain/protocol/types.hpp>
 #include <graphene/db/object.hpp>
 #include <graphene/db/generic_index.hpp>
@@ -49,6 +50,58 @@ namespace graphene { namespace chain {
    >;
    using custom_account_authority_index = generic_index<custom_account_authority_object, custom_account_authority_multi_index_type>;
 
+   /**
+    * @class custom_authority_cache
+    * @brief The custom authorities of (account, operation type) pairs that were looked up at one head block time
+    *
+    * Accounts sending many operations per transaction would otherwise look their authorities up for every one of
+    * them. The entries are dropped when the head block time changes, because the authorities are only valid for
+    * a time range, and when any custom permission or custom account authority changes, including on undo.
+    */
+   class custom_authority_cache
+   {
+      public:
+         /// A secondary index on the custom permission and custom account authority indexes that clears the cache
+         class invalidator : public secondary_index
+         {
+            public:
+               explicit invalidator( custom_authority_cache& cache ) : _cache( cache ) {}
+
+               virtual void object_inserted( const object& obj ) override { _cache.clear(); }
+               virtual void object_removed( const object& obj ) override { _cache.clear(); }
+               virtual void object_modified( const object& after ) override { _cache.clear(); }
+
+            private:
+               custom_authority_cache& _cache;
+         };
+
+         /** @return the cached authorities, or nullptr if they weren't looked up at time now */
+         const vector<authority>* find( account_id_type account, int operation_type, time_point_sec now )const
+         {
+            if( now != _time )
+               return nullptr;
+            auto itr = _entries.find( std::make_pair( account, operation_type ) );
+            return itr != _entries.end() ? &itr->second : nullptr;
+         }
+
+         const vector<authority>& insert( account_id_type account, int operation_type, time_point_sec now,
+                                          vector<authority>&& auths )
+         {
+            if( now != _time )
+            {
+               _entries.clear();
+               _time = now;
+            }
+            return _entries[ std::make_pair( account, operation_type ) ] = std::move( auths );
+         }
+
+         void clear() { _entries.clear(); }
+
+      private:
+         map< std::pair<account_id_type, int>, vector<authority> > _entries;
+         time_point_sec                                             _time;
+   };
+
 } } // graphene::chain
 
 FC_REFLECT_DERIVED( graphene::chain::custom_account_authority_object, (graphene::db::object),
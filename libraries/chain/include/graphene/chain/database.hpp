@@ -28,6 +28,7 @@
 #include <graphene/chain/asset_object.hpp>
 #include <graphene/chain/fork_database.hpp>
 #include <graphene/chain/block_database.hpp>
+#include <graphene/chain/custom_account_authority_object.hpp>
 #include <graphene/chain/genesis_state.hpp>
 #include <graphene/chain/evaluator.hpp>
 
@@ -128,6 +129,15 @@ namespace graphene { namespace chain {
          block_id_type              get_block_id_for_num( uint32_t block_num )const;
          optional<signed_block>     fetch_block_by_id( const block_id_type& id )const;
          optional<signed_block>     fetch_block_by_number( uint32_t num )const;
+         /** @return the block serialized with fc::raw, irreversible blocks are returned as stored without unpacking them */
+         optional<vector<char>>     fetch_serialized_block_by_id( const block_id_type& id )const;
+         /**
+          *  @return blocks first_block_num .. first_block_num + count - 1 of the current chain, irreversible
+          *  blocks are read from the block log in one pass; entries are empty for unknown block numbers
+          */
+         vector<optional<signed_block>> fetch_block_range( uint32_t first_block_num, uint32_t count )const;
+         /** @return the same range as fetch_block_range(), serialized with fc::raw */
+         vector<optional<vector<char>>> fetch_serialized_block_range( uint32_t first_block_num, uint32_t count )const;
          const signed_transaction&  get_recent_transaction( const transaction_id_type& trx_id )const;
          std::vector<block_id_type> get_block_ids_on_fork(block_id_type head_of_fork) const;
 
@@ -144,6 +154,15 @@ namespace graphene { namespace chain {
          void check_transaction_for_duplicated_operations(const signed_transaction& trx);
 
          bool push_block( const signed_block& b, uint32_t skip = skip_nothing );
+
+         /**
+          *  Recovers the signature keys of all transactions in the given blocks on the shared
+          *  thread pool and caches them in signed_transaction::signees, so that applying the
+          *  blocks afterwards only has to look them up.  Does nothing when skip disables the
+          *  signature or authority checks.
+          */
+         void precompute_parallel( const vector<const signed_block*>& blocks, uint32_t skip = skip_nothing )const;
+         void precompute_parallel( const signed_block& block, uint32_t skip = skip_nothing )const;
          processed_transaction push_transaction( const signed_transaction& trx, uint32_t skip = skip_nothing );
          bool _push_block( const signed_block& b );
          processed_transaction _push_transaction( const signed_transaction& trx );
@@ -324,6 +343,12 @@ namespace graphene { namespace chain {
 
          uint32_t last_non_undoable_block_num() const;
          vector<authority> get_account_custom_authorities(account_id_type account, const operation& op)const;
+         /**
+          *  @brief The same authorities as get_account_custom_authorities(), looked up once per head block time
+          *  @note The reference is valid until the next change to the custom permissions or authorities, or to
+          *  the head block time
+          */
+         const vector<authority>& get_cached_account_custom_authorities(account_id_type account, const operation& op);
          //////////////////// db_init.cpp ////////////////////
 
          void initialize_evaluators();
@@ -496,6 +521,9 @@ namespace graphene { namespace chain {
           */
          /// Enable or disable tracking of votes of standby witnesses and committee members
          inline void enable_standby_votes_tracking(bool enable)  { _track_standby_votes = enable; }
+
+         /// Whether to log the time spent reading, decoding and applying blocks after a replay
+         inline void enable_replay_stats(bool enable)  { _replay_stats = enable; }
    protected:
          //Mark pop_undo() as protected -- we do not want outside calling pop_undo(); it should call pop_block() instead
          void pop_undo() { object_database::pop_undo(); }
@@ -576,9 +604,13 @@ namespace graphene { namespace chain {
          public:
             double calculate_vesting_factor(const account_object& stake_account);
             uint32_t get_gpos_current_subperiod();
+            /// Voting stake per number of witnesses (index n stands for 2n or 2n+1) in the last maintenance
+            const vector<uint64_t>& get_witness_count_histogram()const { return _witness_count_histogram_buffer; }
+            /// Voting stake per number of committee members (index n stands for 2n or 2n+1) in the last maintenance
+            const vector<uint64_t>& get_committee_count_histogram()const { return _committee_count_histogram_buffer; }
 
          template<class Type>
-         void perform_account_maintenance(Type tally_helper);
+         void perform_account_maintenance(Type& tally_helper);
          ///@}
          ///@}
 
@@ -596,6 +628,8 @@ namespace graphene { namespace chain {
           */
          block_database   _block_id_to_block;
 
+         custom_authority_cache _custom_authority_cache;
+
          /**
           * Contains the set of ops that are in the process of being applied from
           * the current block.  It contains real and virtual operations in the
@@ -625,6 +659,7 @@ namespace graphene { namespace chain {
 
          fc::hash_ctr_rng<secret_hash_type, 20> _random_number_generator;
          bool                              _slow_replays = false;
+         bool                              _replay_stats = false;
 
          /**
           * Whether database is successfully opened or not.
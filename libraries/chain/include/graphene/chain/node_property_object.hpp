@@ -43,6 +43,10 @@ namespace graphene { namespace chain {
          ~node_property_object(){}
 
          uint32_t skip_flags = 0;
+         /// Fewest deferred accounts per shard when the maintenance vote tally is split across threads
+         size_t min_accounts_per_vote_tally_shard = 1000;
+         /// Match a new bet against the whole book in one pass instead of one maker bet at a time, both give the same result
+         bool batched_bet_matching = true;
          std::map< block_id_type, std::vector< fc::variant_object > > debug_updates;
    };
 } } // graphene::chain
@@ -60,26 +60,32 @@ class proposal_object : public abstract_object<proposal_object>
 
 /**
  *  @brief tracks all of the proposal objects that requrie approval of
- *  an individual account.   
+ *  an individual account, or that the account has approved.
  *
  *  @ingroup object
  *  @ingroup protocol
  *
  *  This is a secondary index on the proposal_index
  *
- *  @note the set of required approvals is constant
+ *  @note the set of required approvals is constant, the available approvals
+ *  change when the proposal is updated
  */
 class required_approval_index : public secondary_index
 {
    public:
       virtual void object_inserted( const object& obj ) override;
       virtual void object_removed( const object& obj ) override;
-      virtual void about_to_modify( const object& before ) override{};
-      virtual void object_modified( const object& after  ) override{};
+      virtual void about_to_modify( const object& before ) override;
+      virtual void object_modified( const object& after  ) override;
 
       void remove( account_id_type a, proposal_id_type p );
 
       map<account_id_type, set<proposal_id_type> > _account_to_proposals;
+
+   private:
+      static flat_set<account_id_type> get_accounts( const proposal_object& p );
+
+      flat_set<account_id_type> _accounts_before_modify;
 };
 
 struct by_expiration{};
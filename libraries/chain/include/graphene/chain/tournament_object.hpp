@@ -231,6 +231,39 @@ namespace graphene { namespace chain {
          flat_set<account_id_type> before_account_ids;
    };
 
+   /**
+    *  @brief Secondary index of the in-progress tournaments that may be able to start new matches
+    *
+    *  The tournament state machine only changes a tournament when it starts or when one of its
+    *  matches completes, so a tournament is queued here whenever it is created or modified while in
+    *  progress, and database::update_tournaments() only checks the queued ones for new matches instead
+    *  of every tournament in progress.
+    *
+    *  The queue is not part of the undo state, so every block remembers the tournaments it took until
+    *  it becomes irreversible.  When a block with the same or a lower number is applied again, the
+    *  blocks that took them were popped or failed, and their tournaments are queued again.  Checking
+    *  a tournament whose matches did not change since its last check leaves the state unchanged, so
+    *  tournaments queued more than once, by undo or because every tournament in progress is queued
+    *  when the database is opened, don't make this node diverge; a missed check would.
+    */
+   class pending_tournament_index : public secondary_index
+   {
+      public:
+         virtual void object_inserted( const object& obj ) override;
+         virtual void object_removed( const object& obj ) override;
+         virtual void object_modified( const object& after  ) override;
+
+         /**
+          *  @return the tournaments to check in block block_num, and empties the queue
+          *  @param last_irreversible_block_num the tournaments taken by blocks up to this one are forgotten
+          */
+         flat_set<tournament_id_type> take_pending_tournaments( uint32_t block_num, uint32_t last_irreversible_block_num );
+      private:
+         flat_set<tournament_id_type> _pending_tournaments;
+         /** the tournaments taken by each block that may still be undone */
+         map< uint32_t, flat_set<tournament_id_type> > _taken_by_block;
+   };
+
 
 } }
 
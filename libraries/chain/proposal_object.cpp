@@ -38,7 +38,7 @@ bool proposal_object::is_authorized_to_execute( database& db ) const
                         [&]( account_id_type id ){ return &id(db).active; },
                         [&]( account_id_type id ){ return &id(db).owner;  },
                         [&]( account_id_type id, const operation& op ){
-                           return db.get_account_custom_authorities(id, op); },
+                           return db.get_cached_account_custom_authorities(id, op); },
                         MUST_IGNORE_CUSTOM_OP_REQD_AUTHS( db.head_block_time() ),
                         db.get_global_properties().parameters.max_authority_depth,
                         true, /* allow committee */
@@ -52,18 +52,24 @@ bool proposal_object::is_authorized_to_execute( database& db ) const
    return true;
 }
 
+flat_set<account_id_type> required_approval_index::get_accounts( const proposal_object& p )
+{
+    flat_set<account_id_type> result;
+    result.reserve( p.required_active_approvals.size() + p.required_owner_approvals.size()
+                    + p.available_active_approvals.size() + p.available_owner_approvals.size() );
+    result.insert( p.required_active_approvals.begin(), p.required_active_approvals.end() );
+    result.insert( p.required_owner_approvals.begin(), p.required_owner_approvals.end() );
+    result.insert( p.available_active_approvals.begin(), p.available_active_approvals.end() );
+    result.insert( p.available_owner_approvals.begin(), p.available_owner_approvals.end() );
+    return result;
+}
+
 void required_approval_index::object_inserted( const object& obj )
 {
     assert( dynamic_cast<const proposal_object*>(&obj) );
     const proposal_object& p = static_cast<const proposal_object&>(obj);
 
-    for( const auto& a : p.required_active_approvals )
-       _account_to_proposals[a].insert( p.id );
-    for( const auto& a : p.required_owner_approvals )
-       _account_to_proposals[a].insert( p.id );
-    for( const auto& a : p.available_active_approvals )
-       _account_to_proposals[a].insert( p.id );
-    for( const auto& a : p.available_owner_approvals )
+    for( const auto& a : get_accounts( p ) )
        _account_to_proposals[a].insert( p.id );
 }
 
@@ -83,16 +89,32 @@ void required_approval_index::object_removed( const object& obj )
     assert( dynamic_cast<const proposal_object*>(&obj) );
     const proposal_object& p = static_cast<const proposal_object&>(obj);
 
-    for( const auto& a : p.required_active_approvals )
-       remove( a, p.id );
-    for( const auto& a : p.required_owner_approvals )
-       remove( a, p.id );
-    for( const auto& a : p.available_active_approvals )
-       remove( a, p.id );
-    for( const auto& a : p.available_owner_approvals )
+    for( const auto& a : get_accounts( p ) )
        remove( a, p.id );
 }
 
+void required_approval_index::about_to_modify( const object& before )
+{
+    assert( dynamic_cast<const proposal_object*>(&before) );
+    _accounts_before_modify = get_accounts( static_cast<const proposal_object&>(before) );
+}
+
+void required_approval_index::object_modified( const object& after )
+{
+    assert( dynamic_cast<const proposal_object*>(&after) );
+    const proposal_object& p = static_cast<const proposal_object&>(after);
+    const flat_set<account_id_type> accounts_after = get_accounts( p );
+
+    // only the available approvals change, drop the accounts whose approval was removed and add the new approvers
+    for( const auto& a : _accounts_before_modify )
+       if( accounts_after.find( a ) == accounts_after.end() )
+          remove( a, p.id );
+    for( const auto& a : accounts_after )
+       if( _accounts_before_modify.find( a ) == _accounts_before_modify.end() )
+          _account_to_proposals[a].insert( p.id );
+    _accounts_before_modify.clear();
+}
+
 } } // graphene::chain
 
 GRAPHENE_EXTERNAL_SERIALIZATION( /*not extern*/, graphene::chain::proposal_object )
@@ -271,8 +271,8 @@ void verify_authority( const vector<operation>& ops, const flat_set<public_key_t
 
    auto approved_by_custom_authority = [&s, &get_custom](
            account_id_type account,
-           operation op ) mutable {
-      auto custom_auths = get_custom( account, op );
+           const operation& op ) mutable {
+      const auto custom_auths = get_custom( account, op );
       for( const auto& auth : custom_auths )
          if( s.check_authority( &auth ) ) return true;
       return false;
@@ -367,8 +367,8 @@ set<public_key_type> signed_transaction::get_required_signatures(
 
    auto approved_by_custom_authority = [&s, &get_custom](
            account_id_type account,
-           operation op ) mutable {
-      auto custom_auths = get_custom( account, op );
+           const operation& op ) mutable {
+      const auto custom_auths = get_custom( account, op );
       for( const auto& auth : custom_auths )
          if( s.check_authority( &auth ) ) return true;
       return false;
@@ -718,6 +718,37 @@ namespace graphene { namespace chain {
          }
       }
    }
+   void pending_tournament_index::object_inserted(const object& obj)
+   {
+      object_modified(obj);
+   }
+
+   void pending_tournament_index::object_removed(const object& obj)
+   {
+      _pending_tournaments.erase(obj.id);
+   }
+
+   void pending_tournament_index::object_modified(const object& after)
+   {
+      assert( dynamic_cast<const tournament_object*>(&after) ); // for debug only
+      const tournament_object& tournament = static_cast<const tournament_object&>(after);
+      if (tournament.get_state() == tournament_state::in_progress)
+         _pending_tournaments.insert(tournament.id);
+   }
+
+   flat_set<tournament_id_type> pending_tournament_index::take_pending_tournaments(uint32_t block_num, uint32_t last_irreversible_block_num)
+   {
+      // the blocks from block_num on were undone before this block is applied again
+      for (auto itr = _taken_by_block.lower_bound(block_num); itr != _taken_by_block.end(); itr = _taken_by_block.erase(itr))
+         _pending_tournaments.insert(itr->second.begin(), itr->second.end());
+      _taken_by_block.erase(_taken_by_block.begin(), _taken_by_block.upper_bound(last_irreversible_block_num));
+
+      flat_set<tournament_id_type> result;
+      result.swap(_pending_tournaments);
+      if (!result.empty())
+         _taken_by_block[block_num] = result;
+      return result;
+   }
 } } // graphene::chain
 
 namespace fc { 
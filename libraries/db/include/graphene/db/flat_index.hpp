@@ -73,6 +73,8 @@ namespace graphene { namespace db {
             _objects[instance] = T();
          }
 
+         virtual bool objects_may_move()const override { return true; }
+
          virtual const object* find( object_id_type id )const override
          {
             assert( id.space() == T::space_id );
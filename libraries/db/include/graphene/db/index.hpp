@@ -28,8 +28,11 @@
 #include <fc/io/raw.hpp>
 #include <fc/io/json.hpp>
 #include <fc/crypto/sha256.hpp>
+#include <algorithm>
 #include <fstream>
+#include <iterator>
 #include <stack>
+#include <type_traits>
 
 namespace graphene { namespace db {
    class object_database;
@@ -98,6 +101,25 @@ namespace graphene { namespace db {
          virtual void open( const fc::path& db ) = 0;
          virtual void save( const fc::path& db ) = 0;
 
+         /**
+          *  Loads the objects from a file like open(), but without notifying secondary indexes.
+          *  Different indexes can be loaded this way concurrently; rebuild_secondary_indexes()
+          *  must be called once all of them are loaded.
+          */
+         virtual void open_objects( const fc::path& db ) = 0;
+         /** Feeds every object of this index to its secondary indexes */
+         virtual void rebuild_secondary_indexes() = 0;
+
+         /**
+          *  Maintains a table from object instance to object so that find() does not
+          *  search the derived index.  Costs one pointer per instance that ever existed
+          *  within pages that still hold objects.
+          */
+         virtual void enable_dense_lookup( bool enable ) = 0;
+
+         /** @return true if creating objects can move the objects already in the index to other addresses */
+         virtual bool objects_may_move()const { return false; }
+
 
 
          /** @return the object with id or nullptr if not found */
@@ -166,13 +188,36 @@ namespace graphene { namespace db {
          /** called just after obj is modified */
          void on_modify( const object& obj );
 
-         template<typename T>
-         T* add_secondary_index()
+         template<typename T, typename... Args>
+         T* add_secondary_index( Args&&... args )
          {
-            _sindex.emplace_back( new T() );
+            _sindex.emplace_back( new T( std::forward<Args>(args)... ) );
             return static_cast<T*>(_sindex.back().get());
          }
 
+         /** @return the secondary index of type T, or nullptr if there is none */
+         template<typename T>
+         const T* find_secondary_index()const
+         {
+            for( const auto& item : _sindex )
+            {
+               const T* result = dynamic_cast<const T*>(item.get());
+               if( result != nullptr ) return result;
+            }
+            return nullptr;
+         }
+
+         template<typename T>
+         T* find_secondary_index()
+         {
+            for( const auto& item : _sindex )
+            {
+               T* result = dynamic_cast<T*>(item.get());
+               if( result != nullptr ) return result;
+            }
+            return nullptr;
+         }
+
          template<typename T>
          const T& get_secondary_index()const
          {
@@ -298,6 +343,53 @@ namespace graphene { namespace db {
          };
    };
    
+   /**
+    *  @class dense_object_table
+    *  @brief Maps object instances to objects through lazily allocated pages of pointers.
+    *
+    *  Unlike direct_index this allows arbitrary gaps between instances, as pages that
+    *  hold no object are released.  Objects must not move in memory while they are
+    *  in the table, which holds for the node based containers of generic_index.
+    */
+   class dense_object_table
+   {
+      public:
+         const object* find( uint64_t instance )const
+         {
+            const uint64_t p = instance >> PAGE_BITS;
+            if( p >= _pages.size() || !_pages[p] ) return nullptr;
+            return _pages[p]->slots[instance & PAGE_MASK];
+         }
+
+         void insert( const object& obj );
+         void remove( const object& obj );
+         void clear() { _pages.clear(); }
+
+      private:
+         static const uint8_t  PAGE_BITS = 12;
+         static const uint64_t PAGE_MASK = (1 << PAGE_BITS) - 1;
+
+         struct page
+         {
+            page() { std::fill( std::begin(slots), std::end(slots), nullptr ); }
+            uint32_t      used = 0;
+            const object* slots[1 << PAGE_BITS];
+         };
+
+         vector< unique_ptr<page> > _pages;
+   };
+
+   template<typename T> class flat_index;
+   template<typename T> class simple_index;
+
+   /** @return the version written by primary_index::save(), see primary_index::get_checkpoint_version() */
+   fc::sha256 checkpoint_format_version();
+
+   /** indexes that already find objects by their position do not need a dense_object_table */
+   template<typename DerivedIndex> struct use_dense_lookup : std::true_type {};
+   template<typename T> struct use_dense_lookup< flat_index<T> > : std::false_type {};
+   template<typename T> struct use_dense_lookup< simple_index<T> > : std::false_type {};
+
    /**
     * @class primary_index
     * @brief  Wraps a derived index to intercept calls to create, modify, and remove so that
@@ -333,17 +425,47 @@ namespace graphene { namespace db {
          {
             if( DirectBits > 0 )
                return _direct_by_id->find( id );
+            if( _dense_by_id )
+            {
+               if( id.space() != object_type::space_id || id.type() != object_type::type_id )
+                  return nullptr;
+               return _dense_by_id->find( id.instance() );
+            }
             return DerivedIndex::find( id );
          }
+
+         virtual void enable_dense_lookup( bool enable )override
+         {
+            // direct_index already provides the same lookup
+            if( DirectBits > 0 || !use_dense_lookup<DerivedIndex>::value ) return;
+            if( enable == bool(_dense_by_id) ) return;
+            if( !enable )
+            {
+               _dense_by_id.reset();
+               return;
+            }
+            _dense_by_id.reset( new dense_object_table );
+            this->inspect_all_objects( [this]( const object& o ) { _dense_by_id->insert( o ); } );
+         }
          
+         /** version of the legacy file format, where every object is packed into a length-prefixed vector */
          fc::sha256 get_object_version()const
          {
             std::string desc = "1.0";//get_type_description<object_type>();
             return fc::sha256::hash(desc);
          }
 
+         /** version of the checkpoint file format, an object count followed by the objects packed back to back */
+         fc::sha256 get_checkpoint_version()const { return checkpoint_format_version(); }
+
          virtual void open( const path& db )override
          { 
+            open_objects( db );
+            rebuild_secondary_indexes();
+         }
+
+         virtual void open_objects( const path& db )override
+         {
             if( !fc::exists( db ) ) return;
             fc::file_mapping fm( db.generic_string().c_str(), fc::read_only );
             fc::mapped_region mr( fm, fc::read_only, 0, fc::file_size(db) );
@@ -352,42 +474,103 @@ namespace graphene { namespace db {
 
             fc::raw::unpack(ds, _next_id);
             fc::raw::unpack(ds, open_ver);
+            if( open_ver == get_checkpoint_version() )
+            {
+               uint64_t count;
+               fc::raw::unpack( ds, count );
+               for( uint64_t i = 0; i < count; ++i )
+               {
+                  object_type obj;
+                  fc::raw::unpack( ds, obj );
+                  DerivedIndex::insert( std::move( obj ) );
+               }
+               return;
+            }
+
             FC_ASSERT( open_ver == get_object_version(), "Incompatible Version, the serialization of objects in this index has changed" );
             vector<char> tmp;
             while( ds.remaining() > 0 ) 
             {
                fc::raw::unpack( ds, tmp );
-               load( tmp );
+               DerivedIndex::insert( fc::raw::unpack<object_type>( tmp ) );
             }
          }
 
+         virtual void rebuild_secondary_indexes()override
+         {
+            if( _sindex.empty() && !_dense_by_id ) return;
+            this->inspect_all_objects( [this]( const object& o ) {
+               if( _dense_by_id )
+                  _dense_by_id->insert( o );
+               for( const auto& item : _sindex )
+                  item->object_inserted( o );
+            });
+         }
+
          virtual void save( const path& db ) override 
          {
             std::ofstream out( db.generic_string(), 
                                std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
             FC_ASSERT( out );
-            auto ver  = get_object_version();
+            auto ver  = get_checkpoint_version();
             fc::raw::pack( out, _next_id );
             fc::raw::pack( out, ver );
+
+            // the object count is patched in once all objects are written
+            const auto count_pos = out.tellp();
+            uint64_t count = 0;
+            fc::raw::pack( out, count );
+
+            const size_t flush_size = 1024 * 1024;
+            vector<char> buffer;
+            buffer.reserve( flush_size );
             this->inspect_all_objects( [&]( const object& o ) {
-                auto vec = fc::raw::pack( static_cast<const object_type&>(o) );
-                auto packed_vec = fc::raw::pack( vec );
-                out.write( packed_vec.data(), packed_vec.size() );
+                const object_type& obj = static_cast<const object_type&>(o);
+                const size_t offset = buffer.size();
+                buffer.resize( offset + fc::raw::pack_size( obj ) );
+                fc::datastream<char*> ds( buffer.data() + offset, buffer.size() - offset );
+                fc::raw::pack( ds, obj );
+                ++count;
+                if( buffer.size() >= flush_size )
+                {
+                   out.write( buffer.data(), buffer.size() );
+                   buffer.clear();
+                }
             });
+            out.write( buffer.data(), buffer.size() );
+
+            out.seekp( count_pos );
+            fc::raw::pack( out, count );
+            FC_ASSERT( out, "Failed to write ${f}", ("f",db) );
          }
 
          virtual const object&  load( const std::vector<char>& data )override
          {
             const auto& result = DerivedIndex::insert( fc::raw::unpack<object_type>( data ) );
+            if( _dense_by_id )
+               _dense_by_id->insert( result );
             for( const auto& item : _sindex )
                item->object_inserted( result );
             return result;
          }
 
 
+         virtual const object&  insert( object&& obj )override
+         {
+            const auto& result = DerivedIndex::insert( std::move( obj ) );
+            if( _dense_by_id )
+               _dense_by_id->insert( result );
+            // undo restores removed objects through here, and remove() took them out of the secondary indexes
+            for( const auto& item : _sindex )
+               item->object_inserted( result );
+            return result;
+         }
+
          virtual const object&  create(const std::function<void(object&)>& constructor )override
          {
             const auto& result = DerivedIndex::create( constructor );
+            if( _dense_by_id )
+               _dense_by_id->insert( result );
             for( const auto& item : _sindex )
                item->object_inserted( result );
             on_add( result );
@@ -399,6 +582,8 @@ namespace graphene { namespace db {
             for( const auto& item : _sindex )
                item->object_removed( obj );
             on_remove(obj);
+            if( _dense_by_id )
+               _dense_by_id->remove( obj );
             DerivedIndex::remove(obj);
          }
 
@@ -439,6 +624,7 @@ namespace graphene { namespace db {
       private:
          object_id_type                                 _next_id;
          const direct_index< object_type, DirectBits >* _direct_by_id = nullptr;
+         unique_ptr< dense_object_table >               _dense_by_id;
    };
 
 } } // graphene::db
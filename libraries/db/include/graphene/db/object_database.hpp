@@ -25,6 +25,7 @@
 #include <graphene/db/object.hpp>
 #include <graphene/db/index.hpp>
 #include <graphene/db/undo_database.hpp>
+#include <graphene/db/object_snapshot.hpp>
 
 #include <fc/log/logger.hpp>
 
@@ -44,6 +45,12 @@ namespace graphene { namespace db {
 
          void reset_indexes() { _index.clear(); _index.resize(255); }
 
+         /**
+          * Lets every index find objects through a table indexed by instance instead of
+          * searching its containers, also for indexes added later.  Off by default.
+          */
+         void enable_dense_lookup( bool enable );
+
          void open(const fc::path& data_dir );
 
          /**
@@ -135,6 +142,8 @@ namespace graphene { namespace db {
                 _index[ObjectType::space_id].resize( 255 );
             assert(!_index[ObjectType::space_id][ObjectType::type_id]);
             unique_ptr<index> indexptr( new IndexType(*this) );
+            if( _dense_lookup )
+               indexptr->enable_dense_lookup( true );
             _index[ObjectType::space_id][ObjectType::type_id] = std::move(indexptr);
             return static_cast<IndexType*>(_index[ObjectType::space_id][ObjectType::type_id].get());
          }
@@ -160,12 +169,16 @@ namespace graphene { namespace db {
 
          friend class base_primary_index;
          friend class undo_database;
+         friend class object_snapshot;
          void save_undo( const object& obj );
          void save_undo_add( const object& obj );
          void save_undo_remove( const object& obj );
 
          fc::path                                                  _data_dir;
          vector< vector< unique_ptr<index> > >                     _index;
+         bool                                                      _dense_lookup = false;
+         /** the snapshot that is being read, if any, gets every object before it changes */
+         object_snapshot*                                          _snapshot = nullptr;
    };
 
 } } // graphene::db
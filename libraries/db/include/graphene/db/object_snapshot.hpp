@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <graphene/db/object.hpp>
+
+#include <fc/filesystem.hpp>
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+
+namespace graphene { namespace db {
+
+   class index;
+   class object_database;
+
+   /**
+    *  @class object_snapshot
+    *  @brief A consistent view of every object of an object_database that other threads can read
+    *  while the database keeps changing
+    *
+    *  Taking the snapshot only records the address of each object.  Before an object that has
+    *  not been read yet is modified or removed, the database hands it to the snapshot, which keeps
+    *  a copy of it, so readers see all objects as they were when the snapshot was taken.  Objects
+    *  created afterwards are not part of it.
+    *
+    *  The snapshot must be created and destroyed on the thread that changes the database, and
+    *  at most one snapshot of a database can exist at a time.
+    */
+   class object_snapshot
+   {
+      public:
+         explicit object_snapshot( object_database& db );
+         ~object_snapshot();
+
+         /** @return the number of indexes in the snapshot, empty indexes included */
+         uint32_t       index_count()const { return _indexes.size(); }
+         const index&   get_index( uint32_t i )const { return *_indexes[i]->idx; }
+         uint8_t        space_id( uint32_t i )const { return _indexes[i]->space_id; }
+         uint8_t        type_id( uint32_t i )const { return _indexes[i]->type_id; }
+         object_id_type get_next_id( uint32_t i )const { return _indexes[i]->next_id; }
+         size_t         object_count( uint32_t i )const { return _indexes[i]->ids.size(); }
+
+         /**
+          *  Calls inspector with the objects of index i in id order, each one as it was when the
+          *  snapshot was taken.  May run on any thread, concurrently for different indexes, but only
+          *  once per index.  The objects must not be kept after inspector returns.
+          */
+         void inspect_objects( uint32_t i, const std::function<void(const object&)>& inspector );
+
+         /**
+          *  Writes index i to file in the same format as object_database checkpoints, so a snapshot
+          *  directory can be opened like a saved object database.  Same threading rules as inspect_objects().
+          */
+         void save_index( uint32_t i, const fc::path& file );
+
+      private:
+         friend class object_database;
+         /** called by the database before obj is modified or removed */
+         void before_change( const object& obj );
+
+         struct index_view
+         {
+            const index*                  idx = nullptr;
+            uint8_t                       space_id = 0;
+            uint8_t                       type_id = 0;
+            object_id_type                next_id;
+            vector<object_id_type>        ids;
+            vector<const object*>         objects;
+            /** copies of the objects that changed before they were read */
+            vector< unique_ptr<object> >  copies;
+            /** set once an object has been read, it is not copied afterwards */
+            vector<bool>                  done;
+            std::mutex                    mutex;
+         };
+
+         object_database&                            _db;
+         vector< unique_ptr<index_view> >            _indexes;
+         /** position in _indexes by space id << 8 | type id */
+         std::unordered_map<uint16_t, uint32_t>      _by_type;
+   };
+
+} } // graphene::db
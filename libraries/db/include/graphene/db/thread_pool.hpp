@@ -0,0 +1,65 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace graphene { namespace db {
+
+   /**
+    *  @class thread_pool
+    *  @brief A fixed set of OS threads executing queued tasks
+    *
+    *  The workers are plain OS threads, not fc threads: tasks must not yield,
+    *  wait on fc futures or touch the object database.  The pool is meant for
+    *  self-contained CPU work such as signature recovery or (de)serialization.
+    *
+    *  run_for_each() blocks the calling thread until all work has finished, so
+    *  it must not be called from inside a task running on the same pool.
+    */
+   class thread_pool
+   {
+      public:
+         /** @param num_threads number of workers, 0 means one per hardware thread */
+         explicit thread_pool( uint32_t num_threads = 0 );
+         ~thread_pool();
+
+         uint32_t size()const { return _workers.size(); }
+
+         /** Queues f, the returned future holds its result or exception */
+         template<typename Functor>
+         auto run( Functor&& f ) -> std::future<decltype(f())>
+         {
+            typedef decltype(f()) result_type;
+            auto task = std::make_shared< std::packaged_task<result_type()> >( std::forward<Functor>(f) );
+            std::future<result_type> result = task->get_future();
+            post( [task](){ (*task)(); } );
+            return result;
+         }
+
+         /**
+          *  Calls f(i) for every i in [0,count), split into contiguous chunks over
+          *  the workers and the calling thread, and waits for all of them.
+          *  If any call throws, the first exception (by chunk) is rethrown.
+          */
+         void run_for_each( size_t count, const std::function<void(size_t)>& f );
+
+         /** @return a pool with one worker per hardware thread, shared by the whole process */
+         static thread_pool& shared();
+
+      private:
+         void post( std::function<void()> task );
+         void worker_loop();
+
+         std::vector<std::thread>           _workers;
+         std::deque< std::function<void()> > _tasks;
+         std::mutex                         _mutex;
+         std::condition_variable            _cv;
+         bool                               _stopping = false;
+   };
+
+} } // graphene::db
@@ -23,6 +23,7 @@
  */
 #pragma once
 #include <graphene/db/object.hpp>
+#include <algorithm>
 #include <deque>
 #include <fc/exception/exception.hpp>
 
@@ -32,12 +33,192 @@ namespace graphene { namespace db {
    using fc::flat_set;
    class object_database;
 
+   /**
+    *  @class undo_log
+    *  @brief A flat map from object ID to Value, iterated in ID order
+    *
+    *  New entries are appended to a short unsorted tail.  Once the tail grows past
+    *  TAIL_SIZE entries it is sorted into a new run, and runs are merged so that each
+    *  one is at least twice as long as the next.  This keeps O(log n) runs, so an
+    *  insert costs amortized O(log n) and a lookup is a binary search per run plus a
+    *  scan of the tail.  Nothing is allocated per entry.  Erased entries are only
+    *  marked and dropped when their run is merged.
+    */
+   template<typename Value>
+   class undo_log
+   {
+      public:
+         struct entry
+         {
+            object_id_type id;
+            Value          value;
+            bool           erased;
+         };
+
+         Value* find( object_id_type id )
+         {
+            entry* e = find_entry( id );
+            return e ? &e->value : nullptr;
+         }
+         const Value* find( object_id_type id )const
+         {
+            const entry* e = const_cast<undo_log*>(this)->find_entry( id );
+            return e ? &e->value : nullptr;
+         }
+         bool contains( object_id_type id )const { return find( id ) != nullptr; }
+
+         /** id must not be in the log yet */
+         void insert( object_id_type id, const Value& value = Value() )
+         {
+            _entries.push_back( entry{ id, value, false } );
+            ++_size;
+            if( _entries.size() - _sorted > TAIL_SIZE )
+               sort_tail();
+         }
+
+         /** @return false if id was not in the log */
+         bool erase( object_id_type id )
+         {
+            entry* e = find_entry( id );
+            if( e == nullptr ) return false;
+            e->erased = true;
+            --_size;
+            return true;
+         }
+
+         size_t size()const  { return _size; }
+         bool   empty()const { return _size == 0; }
+         void   clear()      { _entries.clear(); _runs.clear(); _sorted = 0; _size = 0; }
+
+         /** calls f( id, value ) for every entry, in ID order */
+         template<typename Functor>
+         void for_each( Functor&& f )const
+         {
+            normalize();
+            for( const entry& e : _entries )
+               f( e.id, e.value );
+         }
+
+      private:
+         static const size_t TAIL_SIZE = 32;
+
+         static bool by_id( const entry& a, const entry& b ) { return a.id < b.id; }
+
+         entry* find_entry( object_id_type id )
+         {
+            // an erased entry may be followed by a live one with the same ID, in the same or a later run
+            for( size_t r = 0; r < _runs.size(); ++r )
+            {
+               auto run_end = _entries.begin() + ( r + 1 < _runs.size() ? _runs[r + 1] : _sorted );
+               auto itr = std::lower_bound( _entries.begin() + _runs[r], run_end, id,
+                                            []( const entry& e, object_id_type i ) { return e.id < i; } );
+               for( ; itr != run_end && itr->id == id; ++itr )
+                  if( !itr->erased ) return &*itr;
+            }
+            for( auto itr = _entries.begin() + _sorted; itr != _entries.end(); ++itr )
+               if( itr->id == id && !itr->erased ) return &*itr;
+            return nullptr;
+         }
+
+         /** merges the last run into the one before it and drops erased entries from the result */
+         void merge_last_runs()const
+         {
+            auto first = _entries.begin() + _runs[_runs.size() - 2];
+            std::inplace_merge( first, _entries.begin() + _runs.back(), _entries.end(), by_id );
+            _entries.erase( std::remove_if( first, _entries.end(), []( const entry& e ) { return e.erased; } ),
+                            _entries.end() );
+            _runs.pop_back();
+         }
+
+         /** sorts the tail into a new run and merges runs until each is at least twice as long as the next */
+         void sort_tail()const
+         {
+            std::sort( _entries.begin() + _sorted, _entries.end(), by_id );
+            _runs.push_back( _sorted );
+            while( _runs.size() > 1 &&
+                   _runs.back() - _runs[_runs.size() - 2] < 2 * ( _entries.size() - _runs.back() ) )
+               merge_last_runs();
+            _sorted = _entries.size();
+         }
+
+         /** merges the tail and all runs into a single run without erased entries */
+         void normalize()const
+         {
+            if( _runs.size() <= 1 && _sorted == _entries.size() && _size == _entries.size() ) return;
+            if( _sorted != _entries.size() )
+               sort_tail();
+            while( _runs.size() > 1 )
+               merge_last_runs();
+            if( _size != _entries.size() )
+               _entries.erase( std::remove_if( _entries.begin(), _entries.end(), []( const entry& e ) { return e.erased; } ),
+                               _entries.end() );
+            _sorted = _entries.size();
+            _runs.clear();
+            if( _sorted > 0 )
+               _runs.push_back( 0 );
+         }
+
+         mutable vector<entry>  _entries;
+         mutable vector<size_t> _runs;       ///< start of each sorted run, in _entries order
+         mutable size_t         _sorted = 0; ///< number of leading entries covered by the runs
+         size_t                 _size = 0;   ///< number of entries not erased
+   };
+
+   /**
+    *  @class undo_arena
+    *  @brief Bump allocator holding the saved copies of objects for one undo_state
+    *
+    *  Copies are constructed in place in fixed-size blocks that are recycled through
+    *  the pool of the undo_database, and are all destroyed at once together with the
+    *  state.  Merging two states moves the blocks of the newer one into the older one.
+    */
+   class undo_arena
+   {
+      public:
+         static const size_t BLOCK_SIZE = 64 * 1024;
+
+         /** recycles arena blocks between undo states */
+         class pool
+         {
+            public:
+               ~pool();
+               char* acquire();
+               void  release( char* block );
+            private:
+               static const size_t MAX_FREE_BLOCKS = 256;
+               vector<char*> _free_blocks;
+         };
+
+         explicit undo_arena( pool& p ):_pool(&p){}
+         undo_arena( undo_arena&& other );
+         undo_arena& operator = ( undo_arena&& other );
+         ~undo_arena() { clear(); }
+
+         /** @return a copy of obj owned by the arena */
+         object* clone( const object& obj );
+         /** takes over all copies of other, leaving it empty */
+         void    absorb( undo_arena& other );
+         /** destroys all copies and returns the blocks to the pool */
+         void    clear();
+
+      private:
+         pool*           _pool;
+         vector<char*>   _blocks;
+         vector<object*> _objects;
+         size_t          _used = BLOCK_SIZE; ///< bytes used in _blocks.back()
+   };
+
+   struct no_value {};
+
    struct undo_state
    {
-      unordered_map<object_id_type, unique_ptr<object> > old_values;
-      unordered_map<object_id_type, object_id_type>      old_index_next_ids;
-      std::unordered_set<object_id_type>                 new_ids;
-      unordered_map<object_id_type, unique_ptr<object> > removed;
+      explicit undo_state( undo_arena::pool& p ):arena(p){}
+
+      undo_log<object*>         old_values; ///< values before the first modification, owned by arena
+      undo_log<object_id_type>  old_index_next_ids;
+      undo_log<no_value>        new_ids;
+      undo_log<object*>         removed;    ///< values before removal, owned by arena
+      undo_arena                arena;
    };
 
 
@@ -136,9 +317,11 @@ namespace graphene { namespace db {
          void undo();
          void merge();
          void commit();
+         void apply_undo_state( undo_state& state );
 
          uint32_t                _active_sessions = 0;
          bool                    _disabled = true;
+         undo_arena::pool        _arena_pool;
          std::deque<undo_state>  _stack;
          object_database&        _db;
          size_t                  _max_size = 256;
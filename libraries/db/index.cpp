@@ -26,6 +26,12 @@
 #include <graphene/db/object_database.hpp>
 
 namespace graphene { namespace db {
+   fc::sha256 checkpoint_format_version()
+   {
+      std::string desc = "2.0";
+      return fc::sha256::hash(desc);
+   }
+
    void base_primary_index::save_undo( const object& obj )
    { _db.save_undo( obj ); }
 
@@ -40,4 +46,30 @@ namespace graphene { namespace db {
 
    void base_primary_index::on_modify( const object& obj )
    {for( auto ob : _observers ) ob->on_modify(  obj ); }
+
+   void dense_object_table::insert( const object& obj )
+   {
+      const uint64_t instance = obj.id.instance();
+      const uint64_t p = instance >> PAGE_BITS;
+      if( p >= _pages.size() )
+         _pages.resize( p + 1 );
+      if( !_pages[p] )
+         _pages[p].reset( new page );
+      const object*& slot = _pages[p]->slots[instance & PAGE_MASK];
+      FC_ASSERT( slot == nullptr, "Object ${id} is already in the table", ("id",obj.id) );
+      slot = &obj;
+      ++_pages[p]->used;
+   }
+
+   void dense_object_table::remove( const object& obj )
+   {
+      const uint64_t instance = obj.id.instance();
+      const uint64_t p = instance >> PAGE_BITS;
+      FC_ASSERT( find( instance ) == &obj, "Object ${id} is not in the table", ("id",obj.id) );
+      _pages[p]->slots[instance & PAGE_MASK] = nullptr;
+      if( --_pages[p]->used == 0 )
+         _pages[p].reset();
+      while( !_pages.empty() && !_pages.back() )
+         _pages.pop_back();
+   }
 } } // graphene::chain
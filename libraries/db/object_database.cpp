@@ -22,11 +22,32 @@
  * THE SOFTWARE.
  */
 #include <graphene/db/object_database.hpp>
+#include <graphene/db/thread_pool.hpp>
 
+#include <fc/io/fstream.hpp>
 #include <fc/io/raw.hpp>
 #include <fc/container/flat.hpp>
 #include <fc/uint128.hpp>
 
+#include <fstream>
+
+namespace graphene { namespace db {
+
+   /**
+    *  One entry of the manifest that flush() writes after all index files of a
+    *  checkpoint; open() refuses a checkpoint whose files do not match it.
+    */
+   struct checkpoint_file
+   {
+      uint8_t  space = 0;
+      uint8_t  type = 0;
+      uint64_t size = 0;
+   };
+
+} } // graphene::db
+
+FC_REFLECT( graphene::db::checkpoint_file, (space)(type)(size) )
+
 namespace graphene { namespace db {
 
 object_database::object_database()
@@ -42,6 +63,15 @@ void object_database::close()
 {
 }
 
+void object_database::enable_dense_lookup( bool enable )
+{
+   _dense_lookup = enable;
+   for( auto& space : _index )
+      for( auto& idx : space )
+         if( idx )
+            idx->enable_dense_lookup( enable );
+}
+
 const object* object_database::find_object( object_id_type id )const
 {
    return get_index(id.space(),id.type()).find( id );
@@ -72,13 +102,33 @@ void object_database::flush()
 {
 //   ilog("Save object_database in ${d}", ("d", _data_dir));
    fc::create_directories( _data_dir / "object_database.tmp" / "lock" );
+   vector< std::pair<index*, fc::path> > files;
+   vector< checkpoint_file > manifest;
    for( uint32_t space = 0; space < _index.size(); ++space )
    {
       fc::create_directories( _data_dir / "object_database.tmp" / fc::to_string(space) );
       const auto types = _index[space].size();
       for( uint32_t type = 0; type  <  types; ++type )
          if( _index[space][type] )
-            _index[space][type]->save( _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type) );
+         {
+            files.emplace_back( _index[space][type].get(), _data_dir / "object_database.tmp" / fc::to_string(space)/fc::to_string(type) );
+            manifest.emplace_back();
+            manifest.back().space = space;
+            manifest.back().type = type;
+         }
+   }
+
+   // indexes are independent of each other, so they are written concurrently
+   thread_pool::shared().run_for_each( files.size(), [&files,&manifest]( size_t i ) {
+      files[i].first->save( files[i].second );
+      manifest[i].size = fc::file_size( files[i].second );
+   });
+
+   {
+      std::ofstream out( (_data_dir / "object_database.tmp" / "manifest").generic_string(),
+                         std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+      fc::raw::pack( out, manifest );
+      FC_ASSERT( out, "Failed to write object_database manifest" );
    }
    fc::remove_all( _data_dir / "object_database.tmp" / "lock" );
    if( fc::exists( _data_dir / "object_database" ) )
@@ -104,10 +154,41 @@ void object_database::open(const fc::path& data_dir)
        return;
    }
    ilog("Opening object database from ${d} ...", ("d", data_dir));
+
+   // databases written before the manifest was introduced don't have one and are loaded unchecked
+   const fc::path manifest_file = _data_dir / "object_database" / "manifest";
+   std::map< std::pair<uint8_t,uint8_t>, uint64_t > expected_sizes;
+   if( fc::exists( manifest_file ) )
+   {
+      std::string data;
+      fc::read_file_contents( manifest_file, data );
+      vector< checkpoint_file > manifest;
+      fc::datastream<const char*> ds( data.data(), data.size() );
+      fc::raw::unpack( ds, manifest );
+      for( const auto& file : manifest )
+         expected_sizes[ std::make_pair( file.space, file.type ) ] = file.size;
+   }
+
+   vector< std::pair<index*, fc::path> > files;
    for( uint32_t space = 0; space < _index.size(); ++space )
       for( uint32_t type = 0; type  < _index[space].size(); ++type )
          if( _index[space][type] )
-            _index[space][type]->open( _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type) );
+         {
+            const fc::path file = _data_dir / "object_database" / fc::to_string(space)/fc::to_string(type);
+            auto expected = expected_sizes.find( std::make_pair( uint8_t(space), uint8_t(type) ) );
+            if( expected != expected_sizes.end() )
+               FC_ASSERT( fc::exists( file ) && fc::file_size( file ) == expected->second,
+                          "Object database file ${f} does not match the manifest", ("f",file) );
+            files.emplace_back( _index[space][type].get(), file );
+         }
+
+   // the primary data of all indexes is loaded concurrently, secondary indexes are
+   // populated afterwards since they may be shared or look at other indexes
+   thread_pool::shared().run_for_each( files.size(), [&files]( size_t i ) {
+      files[i].first->open_objects( files[i].second );
+   });
+   for( const auto& file : files )
+      file.first->rebuild_secondary_indexes();
    ilog( "Done opening object database." );
 
 } FC_CAPTURE_AND_RETHROW( (data_dir) ) }
@@ -120,6 +201,8 @@ void object_database::pop_undo()
 
 void object_database::save_undo( const object& obj )
 {
+   if( _snapshot )
+      _snapshot->before_change( obj );
    _undo_db.on_modify( obj );
 }
 
@@ -130,6 +213,8 @@ void object_database::save_undo_add( const object& obj )
 
 void object_database::save_undo_remove(const object& obj)
 {
+   if( _snapshot )
+      _snapshot->before_change( obj );
    _undo_db.on_remove( obj );
 }
 
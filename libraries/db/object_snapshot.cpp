@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/db/object_snapshot.hpp>
+#include <graphene/db/object_database.hpp>
+
+#include <fc/io/raw.hpp>
+
+#include <algorithm>
+#include <fstream>
+
+namespace graphene { namespace db {
+
+object_snapshot::object_snapshot( object_database& db )
+   : _db(db)
+{ try {
+   FC_ASSERT( _db._snapshot == nullptr, "Only one snapshot of a database can exist at a time" );
+   for( uint32_t space_id = 0; space_id < _db._index.size(); ++space_id )
+      for( uint32_t type_id = 0; type_id < _db._index[space_id].size(); ++type_id )
+      {
+         const auto& idx = _db._index[space_id][type_id];
+         if( !idx ) continue;
+         unique_ptr<index_view> view( new index_view );
+         view->idx = idx.get();
+         view->space_id = space_id;
+         view->type_id = type_id;
+         view->next_id = idx->get_next_id();
+         const bool may_move = idx->objects_may_move();
+         idx->inspect_all_objects( [&view,may_move]( const object& o ) {
+            view->ids.push_back( o.id );
+            view->objects.push_back( &o );
+            // the addresses of these objects are not stable, keep a copy right away
+            view->copies.emplace_back( may_move ? o.clone() : unique_ptr<object>() );
+         });
+         view->done.resize( view->ids.size() );
+         _by_type[ uint16_t(space_id << 8 | type_id) ] = _indexes.size();
+         _indexes.emplace_back( std::move( view ) );
+      }
+   _db._snapshot = this;
+} FC_CAPTURE_AND_RETHROW() }
+
+object_snapshot::~object_snapshot()
+{
+   _db._snapshot = nullptr;
+}
+
+void object_snapshot::before_change( const object& obj )
+{
+   auto itr = _by_type.find( uint16_t(obj.id.space() << 8 | obj.id.type()) );
+   if( itr == _by_type.end() ) return;
+   index_view& view = *_indexes[itr->second];
+   auto pos = std::lower_bound( view.ids.begin(), view.ids.end(), obj.id );
+   if( pos == view.ids.end() || *pos != obj.id ) return;
+   const size_t k = pos - view.ids.begin();
+
+   std::lock_guard<std::mutex> lock( view.mutex );
+   if( !view.done[k] && !view.copies[k] )
+      view.copies[k] = obj.clone();
+}
+
+void object_snapshot::inspect_objects( uint32_t i, const std::function<void(const object&)>& inspector )
+{
+   index_view& view = *_indexes[i];
+   for( size_t k = 0; k < view.ids.size(); ++k )
+   {
+      unique_ptr<object> copy;
+      {
+         std::unique_lock<std::mutex> lock( view.mutex );
+         FC_ASSERT( !view.done[k], "The objects of a snapshot index can only be read once" );
+         view.done[k] = true;
+         if( !view.copies[k] )
+         {
+            // the object cannot change while the lock is held
+            inspector( *view.objects[k] );
+            continue;
+         }
+         copy = std::move( view.copies[k] );
+      }
+      inspector( *copy );
+   }
+}
+
+void object_snapshot::save_index( uint32_t i, const fc::path& file )
+{ try {
+   std::ofstream out( file.generic_string(), std::ofstream::binary | std::ofstream::out | std::ofstream::trunc );
+   FC_ASSERT( out, "Unable to open ${f}", ("f",file) );
+   fc::raw::pack( out, get_next_id(i) );
+   fc::raw::pack( out, checkpoint_format_version() );
+   fc::raw::pack( out, uint64_t( object_count(i) ) );
+
+   const size_t flush_size = 1024 * 1024;
+   vector<char> buffer;
+   buffer.reserve( flush_size );
+   inspect_objects( i, [&]( const object& o ) {
+      // pack() yields the same bytes as packing the derived object directly
+      const vector<char> packed = o.pack();
+      buffer.insert( buffer.end(), packed.begin(), packed.end() );
+      if( buffer.size() >= flush_size )
+      {
+         out.write( buffer.data(), buffer.size() );
+         buffer.clear();
+      }
+   });
+   out.write( buffer.data(), buffer.size() );
+   out.close();
+   FC_ASSERT( out, "Error writing ${f}", ("f",file) );
+} FC_CAPTURE_AND_RETHROW( (i)(file) ) }
+
+} } // graphene::db
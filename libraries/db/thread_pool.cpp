@@ -0,0 +1,102 @@
+#include <graphene/db/thread_pool.hpp>
+
+#include <algorithm>
+
+namespace graphene { namespace db {
+
+thread_pool::thread_pool( uint32_t num_threads )
+{
+   if( num_threads == 0 )
+      num_threads = std::max( 1u, std::thread::hardware_concurrency() );
+   _workers.reserve( num_threads );
+   for( uint32_t i = 0; i < num_threads; ++i )
+      _workers.emplace_back( [this](){ worker_loop(); } );
+}
+
+thread_pool::~thread_pool()
+{
+   {
+      std::unique_lock<std::mutex> lock( _mutex );
+      _stopping = true;
+   }
+   _cv.notify_all();
+   for( auto& worker : _workers )
+      worker.join();
+}
+
+void thread_pool::post( std::function<void()> task )
+{
+   {
+      std::unique_lock<std::mutex> lock( _mutex );
+      _tasks.emplace_back( std::move( task ) );
+   }
+   _cv.notify_one();
+}
+
+void thread_pool::worker_loop()
+{
+   while( true )
+   {
+      std::function<void()> task;
+      {
+         std::unique_lock<std::mutex> lock( _mutex );
+         _cv.wait( lock, [this](){ return _stopping || !_tasks.empty(); } );
+         if( _tasks.empty() )
+            return; // stopping and drained
+         task = std::move( _tasks.front() );
+         _tasks.pop_front();
+      }
+      task();
+   }
+}
+
+void thread_pool::run_for_each( size_t count, const std::function<void(size_t)>& f )
+{
+   if( count == 0 )
+      return;
+
+   const size_t chunks = std::min<size_t>( count, size() + 1 );
+   const size_t chunk_size = ( count + chunks - 1 ) / chunks;
+   auto run_chunk = [&f,count]( size_t begin, size_t end ) {
+      for( size_t i = begin; i < end && i < count; ++i )
+         f( i );
+   };
+
+   // the first chunk runs on the calling thread while the workers process the others
+   std::vector< std::future<void> > pending;
+   pending.reserve( chunks );
+   for( size_t begin = chunk_size; begin < count; begin += chunk_size )
+      pending.push_back( run( [run_chunk,begin,chunk_size](){ run_chunk( begin, begin + chunk_size ); } ) );
+
+   std::exception_ptr first_error;
+   try
+   {
+      run_chunk( 0, chunk_size );
+   }
+   catch( ... )
+   {
+      first_error = std::current_exception();
+   }
+   for( auto& result : pending )
+   {
+      try
+      {
+         result.get();
+      }
+      catch( ... )
+      {
+         if( !first_error )
+            first_error = std::current_exception();
+      }
+   }
+   if( first_error )
+      std::rethrow_exception( first_error );
+}
+
+thread_pool& thread_pool::shared()
+{
+   static thread_pool pool;
+   return pool;
+}
+
+} } // graphene::db
@@ -25,8 +25,91 @@
 #include <graphene/db/undo_database.hpp>
 #include <fc/reflect/variant.hpp>
 
+#include <cstddef>
+
 namespace graphene { namespace db {
 
+undo_arena::pool::~pool()
+{
+   for( char* block : _free_blocks )
+      delete[] block;
+}
+
+char* undo_arena::pool::acquire()
+{
+   if( _free_blocks.empty() )
+      return new char[BLOCK_SIZE];
+   char* block = _free_blocks.back();
+   _free_blocks.pop_back();
+   return block;
+}
+
+void undo_arena::pool::release( char* block )
+{
+   if( _free_blocks.size() < MAX_FREE_BLOCKS )
+      _free_blocks.push_back( block );
+   else
+      delete[] block;
+}
+
+undo_arena::undo_arena( undo_arena&& other )
+:_pool(other._pool),_blocks(std::move(other._blocks)),_objects(std::move(other._objects)),_used(other._used)
+{
+   other._blocks.clear();
+   other._objects.clear();
+   other._used = BLOCK_SIZE;
+}
+
+undo_arena& undo_arena::operator = ( undo_arena&& other )
+{
+   if( this == &other ) return *this;
+   clear();
+   _pool = other._pool;
+   std::swap( _blocks, other._blocks );
+   std::swap( _objects, other._objects );
+   _used = other._used;
+   other._used = BLOCK_SIZE;
+   return *this;
+}
+
+object* undo_arena::clone( const object& obj )
+{
+   // keep every copy aligned for any type the objects may contain
+   const size_t alignment = alignof(std::max_align_t);
+   const size_t size = ( obj.object_size() + alignment - 1 ) & ~( alignment - 1 );
+   FC_ASSERT( size <= BLOCK_SIZE, "Object ${id} is too large for the undo arena", ("id",obj.id) );
+   if( _blocks.empty() || _used + size > BLOCK_SIZE )
+   {
+      _blocks.push_back( _pool->acquire() );
+      _used = 0;
+   }
+   object* result = obj.clone_to( _blocks.back() + _used );
+   _used += size;
+   _objects.push_back( result );
+   return result;
+}
+
+void undo_arena::absorb( undo_arena& other )
+{
+   // the partially used block of other goes in front, so that allocation continues in ours
+   _blocks.insert( _blocks.begin(), other._blocks.begin(), other._blocks.end() );
+   _objects.insert( _objects.end(), other._objects.begin(), other._objects.end() );
+   other._blocks.clear();
+   other._objects.clear();
+   other._used = BLOCK_SIZE;
+}
+
+void undo_arena::clear()
+{
+   for( object* obj : _objects )
+      obj->~object();
+   _objects.clear();
+   for( char* block : _blocks )
+      _pool->release( block );
+   _blocks.clear();
+   _used = BLOCK_SIZE;
+}
+
 void undo_database::enable()  { _disabled = false; }
 void undo_database::disable() { _disabled = true; }
 
@@ -40,7 +123,7 @@ undo_database::session undo_database::start_undo_session( bool force_enable )
    while( size() > max_size() )
       _stack.pop_front();
 
-   _stack.emplace_back();
+   _stack.emplace_back( _arena_pool );
    ++_active_sessions;
    return session(*this, disable_on_exit );
 }
@@ -49,47 +132,64 @@ void undo_database::on_create( const object& obj )
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      _stack.emplace_back( _arena_pool );
    auto& state = _stack.back();
    auto index_id = object_id_type( obj.id.space(), obj.id.type(), 0 );
-   auto itr = state.old_index_next_ids.find( index_id );
-   if( itr == state.old_index_next_ids.end() )
-      state.old_index_next_ids[index_id] = obj.id;
-   state.new_ids.insert(obj.id);
+   if( !state.old_index_next_ids.contains( index_id ) )
+      state.old_index_next_ids.insert( index_id, obj.id );
+   state.new_ids.insert( obj.id );
 }
 void undo_database::on_modify( const object& obj )
 {
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      _stack.emplace_back( _arena_pool );
    auto& state = _stack.back();
-   if( state.new_ids.find(obj.id) != state.new_ids.end() )
+   if( state.new_ids.contains( obj.id ) )
       return;
-   auto itr =  state.old_values.find(obj.id);
-   if( itr != state.old_values.end() ) return;
-   state.old_values[obj.id] = obj.clone();
+   if( state.old_values.contains( obj.id ) )
+      return;
+   state.old_values.insert( obj.id, state.arena.clone( obj ) );
 }
 void undo_database::on_remove( const object& obj )
 {
    if( _disabled ) return;
 
    if( _stack.empty() )
-      _stack.emplace_back();
+      _stack.emplace_back( _arena_pool );
    undo_state& state = _stack.back();
-   if( state.new_ids.count(obj.id) )
-   {
-      state.new_ids.erase(obj.id);
+   if( state.new_ids.erase( obj.id ) )
       return;
-   }
-   if( state.old_values.count(obj.id) )
+   object** old_value = state.old_values.find( obj.id );
+   if( old_value != nullptr )
    {
-      state.removed[obj.id] = std::move(state.old_values[obj.id]);
-      state.old_values.erase(obj.id);
+      object* value = *old_value;
+      state.old_values.erase( obj.id );
+      state.removed.insert( obj.id, value );
       return;
    }
-   if( state.removed.count(obj.id) ) return;
-   state.removed[obj.id] = obj.clone();
+   if( state.removed.contains( obj.id ) ) return;
+   state.removed.insert( obj.id, state.arena.clone( obj ) );
+}
+
+void undo_database::apply_undo_state( undo_state& state )
+{
+   state.old_values.for_each( [this]( object_id_type id, object* old_value ) {
+      _db.modify( _db.get_object( id ), [old_value]( object& obj ){ obj.move_from( *old_value ); } );
+   });
+
+   state.new_ids.for_each( [this]( object_id_type id, const no_value& ) {
+      _db.remove( _db.get_object( id ) );
+   });
+
+   state.old_index_next_ids.for_each( [this]( object_id_type index_id, object_id_type next_id ) {
+      _db.get_mutable_index( index_id.space(), index_id.type() ).set_next_id( next_id );
+   });
+
+   state.removed.for_each( [this]( object_id_type, object* old_value ) {
+      _db.insert( std::move( *old_value ) );
+   });
 }
 
 void undo_database::undo()
@@ -98,24 +198,7 @@ void undo_database::undo()
    FC_ASSERT( _active_sessions > 0 );
    disable();
 
-   auto& state = _stack.back();
-   for( auto& item : state.old_values )
-   {
-      _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
-   }
-
-   for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
-   {
-      _db.remove( _db.get_object(*ritr) );
-   }
-
-   for( auto& item : state.old_index_next_ids )
-   {
-      _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
-   }
-
-   for( auto& item : state.removed )
-      _db.insert( std::move(*item.second) );
+   apply_undo_state( _stack.back() );
 
    _stack.pop_back();
    enable();
@@ -177,68 +260,77 @@ void undo_database::merge()
 
    // We can only be outside type A/AB (the nop path) if B is not nop, so it suffices to iterate through B's three containers.
 
+   if( prev_state.old_values.empty() && prev_state.new_ids.empty() &&
+       prev_state.old_index_next_ids.empty() && prev_state.removed.empty() )
+   {
+      // everything is nop in A, so the composition is B (type B / AB)
+      prev_state = std::move( state );
+      _stack.pop_back();
+      --_active_sessions;
+      return;
+   }
+
    // *+upd
-   for( auto& obj : state.old_values )
+   state.old_values.for_each( [&prev_state]( object_id_type id, object* value )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      if( prev_state.new_ids.contains( id ) )
       {
          // new+upd -> new, type A
-         continue;
+         return;
       }
-      if( prev_state.old_values.find(obj.second->id) != prev_state.old_values.end() )
+      if( prev_state.old_values.contains( id ) )
       {
          // upd(was=X) + upd(was=Y) -> upd(was=X), type A
-         continue;
+         return;
       }
       // del+upd -> N/A
-      assert( prev_state.removed.find(obj.second->id) == prev_state.removed.end() );
+      assert( !prev_state.removed.contains( id ) );
       // nop+upd(was=Y) -> upd(was=Y), type B
-      prev_state.old_values[obj.second->id] = std::move(obj.second);
-   }
+      prev_state.old_values.insert( id, value );
+   });
 
    // *+new, but we assume the N/A cases don't happen, leaving type B nop+new -> new
-   for( auto id : state.new_ids )
-      prev_state.new_ids.insert(id);
+   state.new_ids.for_each( [&prev_state]( object_id_type id, const no_value& )
+   {
+      prev_state.new_ids.insert( id );
+   });
 
    // old_index_next_ids can only be updated, iterate over *+upd cases
-   for( auto& item : state.old_index_next_ids )
+   state.old_index_next_ids.for_each( [&prev_state]( object_id_type index_id, object_id_type next_id )
    {
-      if( prev_state.old_index_next_ids.find( item.first ) == prev_state.old_index_next_ids.end() )
+      // upd(was=X)+upd(was=Y) -> upd(was=X), type A, is a no-op
+      if( !prev_state.old_index_next_ids.contains( index_id ) )
       {
          // nop+upd(was=Y) -> upd(was=Y), type B
-         prev_state.old_index_next_ids[item.first] = item.second;
-         continue;
-      }
-      else
-      {
-         // upd(was=X)+upd(was=Y) -> upd(was=X), type A
-         // type A implementation is a no-op, as discussed above, so there is no code here
-         continue;
+         prev_state.old_index_next_ids.insert( index_id, next_id );
       }
-   }
+   });
 
    // *+del
-   for( auto& obj : state.removed )
+   state.removed.for_each( [&prev_state]( object_id_type id, object* value )
    {
-      if( prev_state.new_ids.find(obj.second->id) != prev_state.new_ids.end() )
+      if( prev_state.new_ids.erase( id ) )
       {
          // new + del -> nop (type C)
-         prev_state.new_ids.erase(obj.second->id);
-         continue;
+         return;
       }
-      auto it = prev_state.old_values.find(obj.second->id);
-      if( it != prev_state.old_values.end() )
+      object** old_value = prev_state.old_values.find( id );
+      if( old_value != nullptr )
       {
          // upd(was=X) + del(was=Y) -> del(was=X)
-         prev_state.removed[obj.second->id] = std::move(it->second);
-         prev_state.old_values.erase(obj.second->id);
-         continue;
+         object* was = *old_value;
+         prev_state.old_values.erase( id );
+         prev_state.removed.insert( id, was );
+         return;
       }
       // del + del -> N/A
-      assert( prev_state.removed.find( obj.second->id ) == prev_state.removed.end() );
+      assert( !prev_state.removed.contains( id ) );
       // nop + del(was=Y) -> del(was=Y)
-      prev_state.removed[obj.second->id] = std::move(obj.second);
-   }
+      prev_state.removed.insert( id, value );
+   });
+
+   // the copies taken over from B are owned by B's arena
+   prev_state.arena.absorb( state.arena );
    _stack.pop_back();
    --_active_sessions;
 }
@@ -255,26 +347,7 @@ void undo_database::pop_commit()
 
    disable();
    try {
-      auto& state = _stack.back();
-
-      for( auto& item : state.old_values )
-      {
-         _db.modify( _db.get_object( item.second->id ), [&]( object& obj ){ obj.move_from( *item.second ); } );
-      }
-
-      for( auto ritr = state.new_ids.begin(); ritr != state.new_ids.end(); ++ritr  )
-      {
-         _db.remove( _db.get_object(*ritr) );
-      }
-
-      for( auto& item : state.old_index_next_ids )
-      {
-         _db.get_mutable_index( item.first.space(), item.first.type() ).set_next_id( item.second );
-      }
-
-      for( auto& item : state.removed )
-         _db.insert( std::move(*item.second) );
-
+      apply_undo_state( _stack.back() );
       _stack.pop_back();
    }
    catch ( const fc::exception& e )
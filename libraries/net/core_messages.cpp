@@ -23,6 +23,8 @@
  */
 #include <graphene/net/core_messages.hpp>
 
+#include <fc/io/raw.hpp>
+
 
 namespace graphene { namespace net {
 
@@ -46,5 +48,19 @@ namespace graphene { namespace net {
   const core_message_type_enum get_current_connections_request_message::type = core_message_type_enum::get_current_connections_request_message_type;
   const core_message_type_enum get_current_connections_reply_message::type   = core_message_type_enum::get_current_connections_reply_message_type;
 
+  message block_message::from_serialized_block( std::vector<char>&& serialized_block, const block_id_type& id )
+  {
+     // a block_message is packed as the block followed by its id
+     message result;
+     result.msg_type = block_message::type;
+     result.data = std::move( serialized_block );
+     const size_t block_size = result.data.size();
+     result.data.resize( block_size + fc::raw::pack_size( id ) );
+     fc::datastream<char*> ds( result.data.data() + block_size, result.data.size() - block_size );
+     fc::raw::pack( ds, id );
+     result.size = (uint32_t)result.data.size();
+     return result;
+  }
+
 } } // graphene::net
 
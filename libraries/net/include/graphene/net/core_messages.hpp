@@ -24,6 +24,7 @@
 #pragma once
 
 #include <graphene/net/config.hpp>
+#include <graphene/net/message.hpp>
 #include <graphene/chain/protocol/block.hpp>
 
 #include <fc/crypto/ripemd160.hpp>
@@ -110,6 +111,12 @@ namespace graphene { namespace net {
       block_message(const signed_block& blk )
       :block(blk),block_id(blk.id()){}
 
+      /**
+       *  @return the same message as message(block_message(block)), built from the block as serialized
+       *  with fc::raw, e.g. as stored in the block_database, without unpacking and packing it again
+       */
+      static message from_serialized_block( std::vector<char>&& serialized_block, const block_id_type& id );
+
       signed_block    block;
       block_id_type   block_id;
 
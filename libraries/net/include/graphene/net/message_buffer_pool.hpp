@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace graphene { namespace net {
+
+/**
+ *  Hands out the buffers that P2P messages are encrypted and decrypted in.  Buffer sizes are powers
+ *  of two from 4 KiB up to the largest message, and a buffer is put back in the pool when its last
+ *  reference goes away, so relaying messages of similar sizes doesn't allocate.  The free buffers
+ *  of all size classes together never hold more than get_max_free_bytes(), anything released past
+ *  that is deleted.
+ */
+class message_buffer_pool
+{
+  public:
+    static message_buffer_pool& instance();
+
+    static const size_t smallest_buffer_size = 4096;
+    /** room for the largest message, its header and padding */
+    static const size_t largest_buffer_size = 4 * 1024 * 1024;
+
+    /** @return a buffer of at least size bytes */
+    std::shared_ptr<char> get_buffer( size_t size );
+
+    /** caps the bytes kept in free buffers, free buffers past the new cap are deleted right away */
+    void set_max_free_bytes( size_t max_free_bytes );
+    size_t get_max_free_bytes() const { return _max_free_bytes; }
+    /** @return the bytes currently kept in free buffers */
+    size_t get_free_bytes() const { return _free_bytes; }
+
+    /** counts bytes that had to be copied to frame or unframe a message */
+    void record_bytes_copied( size_t bytes ) { _bytes_copied += bytes; }
+
+    uint64_t get_buffers_allocated() const { return _buffers_allocated; }
+    uint64_t get_buffers_reused() const { return _buffers_reused; }
+    uint64_t get_bytes_copied() const { return _bytes_copied; }
+
+  private:
+    message_buffer_pool();
+
+    void release_buffer( char* buffer, size_t size_class );
+    /** deletes free buffers, largest first, until at most _max_free_bytes are kept; requires _mutex */
+    void trim_free_buffers();
+
+    std::mutex                       _mutex;
+    /** free buffers by size class */
+    std::vector<std::vector<char*>>  _free_buffers;
+    std::atomic<size_t>              _free_bytes;
+    std::atomic<size_t>              _max_free_bytes;
+    std::atomic<uint64_t>            _buffers_allocated;
+    std::atomic<uint64_t>            _buffers_reused;
+    std::atomic<uint64_t>            _bytes_copied;
+};
+
+} } // graphene::net
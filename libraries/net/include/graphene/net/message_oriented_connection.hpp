@@ -31,6 +31,19 @@ namespace graphene { namespace net {
 
   class message_oriented_connection;
 
+  /**
+   *  A message laid out the way it goes on the wire (header, body and padding to 16 bytes), but not
+   *  yet encrypted.  Frames are never modified once built, so one frame can be queued on any
+   *  number of connections and only the per-connection encryption happens for each peer.
+   */
+  struct message_frame
+  {
+    std::shared_ptr<const char> data;
+    size_t                      size = 0;
+
+    static message_frame from_message( const message& message_to_frame );
+  };
+
   /** receives incoming messages from a message_oriented_connection object */
   class message_oriented_connection_delegate 
   {
@@ -52,6 +65,7 @@ namespace graphene { namespace net {
        void connect_to(const fc::ip::endpoint& remote_endpoint);
 
        void send_message(const message& message_to_send);
+       void send_frame(const message_frame& frame_to_send);
        void close_connection();
        void destroy_connection();
 
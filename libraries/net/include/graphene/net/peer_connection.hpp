@@ -65,7 +65,8 @@ namespace graphene { namespace net
       virtual void on_message(peer_connection* originating_peer,
                               const message& received_message) = 0;
       virtual void on_connection_closed(peer_connection* originating_peer) = 0;
-      virtual message get_message_for_item(const item_id& item) = 0;
+      /** returns the frame for an item, shared with every other peer the item is sent to */
+      virtual message_frame get_frame_for_item(const item_id& item) = 0;
     };
 
     class peer_connection;
@@ -120,7 +121,7 @@ namespace graphene { namespace net
           enqueue_time(enqueue_time)
         {}
 
-        virtual message get_message(peer_connection_delegate* node) = 0;
+        virtual message_frame get_frame(peer_connection_delegate* node) = 0;
         /** returns roughly the number of bytes of memory the message is consuming while
          * it is sitting on the queue
          */
@@ -142,13 +143,14 @@ namespace graphene { namespace net
           message_send_time_field_offset(message_send_time_field_offset)
         {}
 
-        message get_message(peer_connection_delegate* node) override;
+        message_frame get_frame(peer_connection_delegate* node) override;
         size_t get_size_in_queue() override;
       };
 
       /* when you queue up a 'virtual_queued_message', we just queue up the hash of the
        * item we want to send.  When it reaches the top of the queue, we make a callback
-       * to the node to generate the message.
+       * to the node for the message's frame, which broadcast items share with every
+       * other peer they are sent to.
        */
       struct virtual_queued_message : queued_message
       {
@@ -158,7 +160,7 @@ namespace graphene { namespace net
           item_to_send(std::move(item_to_send))
         {}
 
-        message get_message(peer_connection_delegate* node) override;
+        message_frame get_frame(peer_connection_delegate* node) override;
         size_t get_size_in_queue() override;
       };
 
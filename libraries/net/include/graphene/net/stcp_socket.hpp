@@ -50,6 +50,12 @@ class stcp_socket : public virtual fc::iostream
     virtual size_t   writesome( const char* buffer, size_t len );
     virtual size_t   writesome( const std::shared_ptr<const char>& buf, size_t len, size_t offset );
 
+    /**
+     *  Encrypts the frame into a pooled buffer and writes all of it.  len must be a multiple of 16.
+     *  The frame itself is left untouched, so the same frame can be written to several sockets.
+     */
+    void             write_frame( const std::shared_ptr<const char>& frame, size_t len );
+
     virtual void     flush();
     virtual void     close();
 
@@ -0,0 +1,129 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/net/message_buffer_pool.hpp>
+#include <graphene/net/config.hpp>
+
+namespace graphene { namespace net {
+
+const size_t message_buffer_pool::smallest_buffer_size;
+const size_t message_buffer_pool::largest_buffer_size;
+
+namespace {
+  static_assert( message_buffer_pool::largest_buffer_size >= MAX_MESSAGE_SIZE + 16, "the largest buffer must hold the largest message" );
+  // by default free buffers of all size classes together keep at most this many bytes
+  const size_t default_max_free_bytes = 32 * 1024 * 1024;
+
+  size_t get_size_class( size_t size )
+  {
+    size_t size_class = 0;
+    for( size_t class_size = message_buffer_pool::smallest_buffer_size; class_size < size; class_size *= 2 )
+      ++size_class;
+    return size_class;
+  }
+}
+
+message_buffer_pool& message_buffer_pool::instance()
+{
+  // never destroyed, buffers may be released by connections that outlive static destruction
+  static message_buffer_pool* pool = new message_buffer_pool;
+  return *pool;
+}
+
+message_buffer_pool::message_buffer_pool() :
+  _free_buffers( get_size_class( largest_buffer_size ) + 1 ),
+  _free_bytes(0),
+  _max_free_bytes(default_max_free_bytes),
+  _buffers_allocated(0),
+  _buffers_reused(0),
+  _bytes_copied(0)
+{
+}
+
+std::shared_ptr<char> message_buffer_pool::get_buffer( size_t size )
+{
+  if( size > largest_buffer_size )
+  {
+    ++_buffers_allocated;
+    return std::shared_ptr<char>( new char[size], [](char* p){ delete[] p; } );
+  }
+
+  const size_t size_class = get_size_class( size );
+  char* buffer = nullptr;
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    std::vector<char*>& free_buffers = _free_buffers[size_class];
+    if( !free_buffers.empty() )
+    {
+      buffer = free_buffers.back();
+      free_buffers.pop_back();
+      _free_bytes -= smallest_buffer_size << size_class;
+    }
+  }
+  if( buffer )
+    ++_buffers_reused;
+  else
+  {
+    buffer = new char[smallest_buffer_size << size_class];
+    ++_buffers_allocated;
+  }
+  return std::shared_ptr<char>( buffer, [this, size_class](char* p){ release_buffer( p, size_class ); } );
+}
+
+void message_buffer_pool::release_buffer( char* buffer, size_t size_class )
+{
+  const size_t buffer_size = smallest_buffer_size << size_class;
+  {
+    std::lock_guard<std::mutex> lock( _mutex );
+    if( _free_bytes + buffer_size <= _max_free_bytes )
+    {
+      _free_buffers[size_class].push_back( buffer );
+      _free_bytes += buffer_size;
+      return;
+    }
+  }
+  delete[] buffer;
+}
+
+void message_buffer_pool::set_max_free_bytes( size_t max_free_bytes )
+{
+  std::lock_guard<std::mutex> lock( _mutex );
+  _max_free_bytes = max_free_bytes;
+  trim_free_buffers();
+}
+
+void message_buffer_pool::trim_free_buffers()
+{
+  for( size_t size_class = _free_buffers.size(); size_class-- > 0 && _free_bytes > _max_free_bytes; )
+  {
+    std::vector<char*>& free_buffers = _free_buffers[size_class];
+    while( !free_buffers.empty() && _free_bytes > _max_free_bytes )
+    {
+      delete[] free_buffers.back();
+      free_buffers.pop_back();
+      _free_bytes -= smallest_buffer_size << size_class;
+    }
+  }
+}
+
+} } // graphene::net
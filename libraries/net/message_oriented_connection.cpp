@@ -30,6 +30,7 @@
 
 #include <graphene/net/message_oriented_connection.hpp>
 #include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/message_buffer_pool.hpp>
 #include <graphene/net/config.hpp>
 
 #include <atomic>
@@ -80,7 +81,7 @@ namespace graphene { namespace net {
                                        message_oriented_connection_delegate* delegate = nullptr);
       ~message_oriented_connection_impl();
 
-      void send_message(const message& message_to_send);
+      void send_frame(const message_frame& frame_to_send);
       void close_connection();
       void destroy_connection();
 
@@ -183,8 +184,10 @@ namespace graphene { namespace net {
           size_t remaining_bytes_with_padding = 16 * ((m.size - LEFTOVER + 15) / 16);
           m.data.resize(LEFTOVER + remaining_bytes_with_padding); //give extra 16 bytes to allow for padding added in send call
           std::copy(buffer + sizeof(message_header), buffer + sizeof(buffer), m.data.begin());
+          message_buffer_pool::instance().record_bytes_copied(LEFTOVER);
           if (remaining_bytes_with_padding)
           {
+            // the rest of the message is decrypted straight into the message in one read
             _sock.read(&m.data[LEFTOVER], remaining_bytes_with_padding);
             _bytes_received += remaining_bytes_with_padding;
           }
@@ -244,7 +247,7 @@ namespace graphene { namespace net {
         throw *exception_to_rethrow;
     }
 
-    void message_oriented_connection_impl::send_message(const message& message_to_send)
+    void message_oriented_connection_impl::send_frame(const message_frame& frame_to_send)
     {
       VERIFY_CORRECT_THREAD();
 #if 0 // this gets too verbose
@@ -263,22 +266,9 @@ namespace graphene { namespace net {
 
       try
       {
-        size_t size_of_message_and_header = sizeof(message_header) + message_to_send.size;
-        if( message_to_send.size > MAX_MESSAGE_SIZE )
-           elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
-        //pad the message we send to a multiple of 16 bytes
-        size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
-        std::unique_ptr<char[]> padded_message(new char[size_with_padding]);
-
-        memcpy(padded_message.get(), (char*)&message_to_send, sizeof(message_header));
-        memcpy(padded_message.get() + sizeof(message_header), message_to_send.data.data(), message_to_send.size );
-        char* paddingSpace = padded_message.get() + sizeof(message_header) + message_to_send.size;
-        size_t toClean = size_with_padding - size_of_message_and_header;
-        memset(paddingSpace, 0, toClean);
-
-        _sock.write(padded_message.get(), size_with_padding);
+        _sock.write_frame(frame_to_send.data, frame_to_send.size);
         _sock.flush();
-        _bytes_sent += size_with_padding;
+        _bytes_sent += frame_to_send.size;
         _last_message_sent_time = fc::time_point::now();
       } FC_RETHROW_EXCEPTIONS( warn, "unable to send message" );
     }
@@ -349,6 +339,28 @@ namespace graphene { namespace net {
 
   } // end namespace graphene::net::detail
 
+  message_frame message_frame::from_message(const message& message_to_frame)
+  {
+    size_t size_of_message_and_header = sizeof(message_header) + message_to_frame.size;
+    if( message_to_frame.size > MAX_MESSAGE_SIZE )
+       elog("Trying to send a message larger than MAX_MESSAGE_SIZE. This probably won't work...");
+    //pad the message we send to a multiple of 16 bytes
+    size_t size_with_padding = 16 * ((size_of_message_and_header + 15) / 16);
+    std::shared_ptr<char> padded_message = message_buffer_pool::instance().get_buffer(size_with_padding);
+
+    memcpy(padded_message.get(), (char*)&message_to_frame, sizeof(message_header));
+    memcpy(padded_message.get() + sizeof(message_header), message_to_frame.data.data(), message_to_frame.size );
+    message_buffer_pool::instance().record_bytes_copied(size_of_message_and_header);
+    char* paddingSpace = padded_message.get() + sizeof(message_header) + message_to_frame.size;
+    size_t toClean = size_with_padding - size_of_message_and_header;
+    memset(paddingSpace, 0, toClean);
+
+    message_frame frame;
+    frame.data = std::move(padded_message);
+    frame.size = size_with_padding;
+    return frame;
+  }
+
 
   message_oriented_connection::message_oriented_connection(message_oriented_connection_delegate* delegate) :
     my(new detail::message_oriented_connection_impl(this, delegate))
@@ -381,7 +393,12 @@ namespace graphene { namespace net {
 
   void message_oriented_connection::send_message(const message& message_to_send)
   {
-    my->send_message(message_to_send);
+    my->send_frame(message_frame::from_message(message_to_send));
+  }
+
+  void message_oriented_connection::send_frame(const message_frame& frame_to_send)
+  {
+    my->send_frame(frame_to_send);
   }
 
   void message_oriented_connection::close_connection()
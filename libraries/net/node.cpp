@@ -30,6 +30,8 @@
 #include <iostream>
 #include <algorithm>
 #include <tuple>
+#include <future>
+#include <chrono>
 #include <boost/tuple/tuple.hpp>
 #include <boost/circular_buffer.hpp>
 
@@ -75,12 +77,15 @@
 #include <graphene/net/peer_database.hpp>
 #include <graphene/net/peer_connection.hpp>
 #include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/message_buffer_pool.hpp>
 #include <graphene/net/config.hpp>
 #include <graphene/net/exceptions.hpp>
 
 #include <graphene/chain/config.hpp>
 #include <graphene/chain/protocol/fee_schedule.hpp>
 
+#include <graphene/db/thread_pool.hpp>
+
 #include <fc/git_revision.hpp>
 
 //#define ENABLE_DEBUG_ULOGS
@@ -136,6 +141,8 @@ namespace graphene { namespace net {
       {
         message_hash_type message_hash;
         message           message_body;
+        /** built the first time a peer is sent the message, then shared by every peer queue */
+        mutable message_frame message_frame_to_send;
         uint32_t          block_clock_when_received;
 
         // for network performance stats
@@ -176,6 +183,7 @@ namespace graphene { namespace net {
       void cache_message( const message& message_to_cache, const message_hash_type& hash_of_message_to_cache,
                         const message_propagation_data& propagation_data, const fc::uint160_t& message_content_hash );
       message get_message( const message_hash_type& hash_of_message_to_lookup );
+      message_frame get_message_frame( const message_hash_type& hash_of_message_to_lookup );
       message_propagation_data get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const;
       size_t size() const { return _message_cache.size(); }
     };
@@ -209,6 +217,17 @@ namespace graphene { namespace net {
       FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
     }
 
+    message_frame blockchain_tied_message_cache::get_message_frame( const message_hash_type& hash_of_message_to_lookup )
+    {
+      message_cache_container::index<message_hash_index>::type::const_iterator iter =
+         _message_cache.get<message_hash_index>().find(hash_of_message_to_lookup );
+      if( iter == _message_cache.get<message_hash_index>().end() )
+        FC_THROW_EXCEPTION(  fc::key_not_found_exception, "Requested message not in cache" );
+      if( !iter->message_frame_to_send.data )
+        iter->message_frame_to_send = message_frame::from_message( iter->message_body );
+      return iter->message_frame_to_send;
+    }
+
     message_propagation_data blockchain_tied_message_cache::get_message_propagation_data( const fc::uint160_t& hash_of_message_contents_to_lookup ) const
     {
       if( hash_of_message_contents_to_lookup != fc::uint160_t() )
@@ -450,6 +469,10 @@ namespace graphene { namespace net { namespace detail {
       active_sync_requests_map              _active_sync_requests; /// list of sync blocks we've asked for from peers but have not yet received
       std::list<graphene::net::block_message> _new_received_sync_items; /// list of sync blocks we've just received but haven't yet tried to process
       std::list<graphene::net::block_message> _received_sync_items; /// list of sync blocks we've received, but can't yet process because we are still missing blocks that come earlier in the chain
+
+      typedef std::vector< graphene::chain::flat_set<graphene::chain::public_key_type> > block_signees;
+      /// signature keys of the transactions in received sync blocks, recovered on worker threads while the blocks wait in the backlog
+      std::unordered_map<graphene::net::block_id_type, std::future<block_signees> > _sync_block_signees;
       // @}
 
       fc::future<void> _process_backlog_of_sync_blocks_done;
@@ -683,9 +706,13 @@ namespace graphene { namespace net { namespace detail {
       void process_backlog_of_sync_blocks();
       void trigger_process_backlog_of_sync_blocks();
       void process_block_during_sync(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash);
+      void start_sync_block_signature_recovery(const graphene::net::block_message& block_message);
+      void apply_sync_block_signees(graphene::net::block_message& block_message);
+      void drop_unneeded_sync_block_signees();
       void process_block_during_normal_operation(peer_connection* originating_peer, const graphene::net::block_message& block_message, const message_hash_type& message_hash);
       void process_block_message(peer_connection* originating_peer, const message& message_to_process, const message_hash_type& message_hash);
 
+      void prevalidate_transaction(const std::shared_ptr<graphene::net::trx_message>& transaction_message);
       void process_ordinary_message(peer_connection* originating_peer, const message& message_to_process, const message_hash_type& message_hash);
 
       void start_synchronizing();
@@ -750,7 +777,7 @@ namespace graphene { namespace net { namespace detail {
       void                       set_total_bandwidth_limit( uint32_t upload_bytes_per_second, uint32_t download_bytes_per_second );
       void                       disable_peer_advertising();
       fc::variant_object         get_call_statistics() const;
-      message                    get_message_for_item(const item_id& item) override;
+      message_frame              get_frame_for_item(const item_id& item) override;
 
       fc::variant_object         network_get_info() const;
       fc::variant_object         network_get_usage_stats() const;
@@ -2742,21 +2769,21 @@ namespace graphene { namespace net { namespace detail {
       }
     }
 
-    message node_impl::get_message_for_item(const item_id& item)
+    message_frame node_impl::get_frame_for_item(const item_id& item)
     {
       try
       {
-        return _message_cache.get_message(item.item_hash);
+        return _message_cache.get_message_frame(item.item_hash);
       }
       catch (fc::key_not_found_exception&)
       {}
       try
       {
-        return _delegate->get_item(item);
+        return message_frame::from_message(_delegate->get_item(item));
       }
       catch (fc::key_not_found_exception&)
       {}
-      return item_not_available_message(item);
+      return message_frame::from_message(item_not_available_message(item));
     }
 
     void node_impl::on_fetch_items_message(peer_connection* originating_peer, const fetch_items_message& fetch_items_message_received)
@@ -2769,7 +2796,8 @@ namespace graphene { namespace net { namespace detail {
 
       fc::optional<message> last_block_message_sent;
 
-      std::list<message> reply_messages;
+      // replies that are in the message cache are queued by item id so they go out in the cached frame
+      std::list<std::pair<message, fc::optional<item_hash_t> > > reply_messages;
       for (const item_hash_t& item_hash : fetch_items_message_received.items_to_fetch)
       {
         try
@@ -2777,8 +2805,8 @@ namespace graphene { namespace net { namespace detail {
           message requested_message = _message_cache.get_message(item_hash);
           dlog("received item request for item ${id} from peer ${endpoint}, returning the item from my message cache",
                ("endpoint", originating_peer->get_remote_endpoint())
-               ("id", requested_message.id()));
-          reply_messages.push_back(requested_message);
+               ("id", item_hash));
+          reply_messages.emplace_back(requested_message, item_hash);
           if (fetch_items_message_received.item_type == block_message_type)
             last_block_message_sent = requested_message;
           continue;
@@ -2796,14 +2824,14 @@ namespace graphene { namespace net { namespace detail {
                ("id", requested_message.id())
                ("size", requested_message.size)
                ("endpoint", originating_peer->get_remote_endpoint()));
-          reply_messages.push_back(requested_message);
+          reply_messages.emplace_back(requested_message, fc::optional<item_hash_t>());
           if (fetch_items_message_received.item_type == block_message_type)
             last_block_message_sent = requested_message;
           continue;
         }
         catch (fc::key_not_found_exception&)
         {
-          reply_messages.push_back(item_not_available_message(item_to_fetch));
+          reply_messages.emplace_back(item_not_available_message(item_to_fetch), fc::optional<item_hash_t>());
           dlog("received item request from peer ${endpoint} but we don't have it",
                ("endpoint", originating_peer->get_remote_endpoint()));
         }
@@ -2817,12 +2845,14 @@ namespace graphene { namespace net { namespace detail {
         originating_peer->last_block_time_delegate_has_seen = _delegate->get_block_time(block.block_id);
       }
 
-      for (const message& reply : reply_messages)
+      for (const auto& reply : reply_messages)
       {
-        if (reply.msg_type == block_message_type)
-          originating_peer->send_item(item_id(block_message_type, reply.as<graphene::net::block_message>().block_id));
+        if (reply.first.msg_type == block_message_type)
+          originating_peer->send_item(item_id(block_message_type, reply.first.as<graphene::net::block_message>().block_id));
+        else if (reply.second)
+          originating_peer->send_item(item_id(reply.first.msg_type, *reply.second));
         else
-          originating_peer->send_message(reply);
+          originating_peer->send_message(reply.first);
       }
     }
 
@@ -3035,6 +3065,10 @@ namespace graphene { namespace net { namespace detail {
         trigger_fetch_sync_items_loop();
       }
 
+      // stop waiting for the keys of sync blocks that no remaining peer will hand us
+      if (!originating_peer->ids_of_items_to_get.empty())
+        drop_unneeded_sync_block_signees();
+
       if (!originating_peer->items_requested_from_peer.empty())
       {
         for (auto item_and_time : originating_peer->items_requested_from_peer)
@@ -3303,6 +3337,7 @@ namespace graphene { namespace net { namespace detail {
             {
               graphene::net::block_message block_message_to_process = *received_block_iter;
               _received_sync_items.erase(received_block_iter);
+              apply_sync_block_signees(block_message_to_process);
               _handle_message_calls_in_progress.emplace_back(fc::async([this, block_message_to_process](){
                 send_sync_block_to_node_delegate(block_message_to_process);
               }, "send_sync_block_to_node_delegate"));
@@ -3312,6 +3347,7 @@ namespace graphene { namespace net { namespace detail {
             else
             {
               dlog("Already received and accepted this block (presumably through normal inventory mechanism), treating it as accepted");
+              _sync_block_signees.erase(received_block_iter->block_id);
               std::vector< peer_connection_ptr > peers_needing_next_batch;
               for (const peer_connection_ptr& peer : _active_connections)
               {
@@ -3375,10 +3411,77 @@ namespace graphene { namespace net { namespace detail {
 
       // add it to the front of _received_sync_items, then process _received_sync_items to try to
       // pass as many messages as possible to the client.
+      start_sync_block_signature_recovery( block_message_to_process );
       _new_received_sync_items.push_front( block_message_to_process );
       trigger_process_backlog_of_sync_blocks();
     }
 
+    void node_impl::start_sync_block_signature_recovery( const graphene::net::block_message& block_message_to_process )
+    {
+      VERIFY_CORRECT_THREAD();
+      if( block_message_to_process.block.transactions.empty() )
+        return;
+
+      // The workers recover the keys from their own copy of the block, the results are only
+      // copied into the block message on this thread, when it is handed to the client.
+      std::shared_ptr<const signed_block> block = std::make_shared<signed_block>( block_message_to_process.block );
+      const graphene::chain::chain_id_type chain_id = _chain_id;
+      _sync_block_signees[block_message_to_process.block_id] = graphene::db::thread_pool::shared().run(
+        [block, chain_id]() -> block_signees {
+          block_signees result;
+          result.reserve( block->transactions.size() );
+          for( const auto& trx : block->transactions )
+          {
+            try
+            {
+              result.push_back( trx.get_signature_keys( chain_id ) );
+            }
+            catch( const fc::exception& )
+            {
+              result.emplace_back(); // leave it to the client to reject the transaction
+            }
+          }
+          return result;
+        });
+    }
+
+    void node_impl::apply_sync_block_signees( graphene::net::block_message& block_message_to_process )
+    {
+      VERIFY_CORRECT_THREAD();
+      auto signees_iter = _sync_block_signees.find( block_message_to_process.block_id );
+      if( signees_iter == _sync_block_signees.end() )
+        return;
+
+      // don't stall the p2p thread on a recovery that is still running, the client will do it on its own
+      if( signees_iter->second.wait_for( std::chrono::seconds(0) ) == std::future_status::ready )
+      {
+        block_signees signees = signees_iter->second.get();
+        auto& transactions = block_message_to_process.block.transactions;
+        if( signees.size() == transactions.size() )
+          for( size_t i = 0; i < signees.size(); ++i )
+            if( !signees[i].empty() )
+              transactions[i].signees = std::move( signees[i] );
+      }
+      _sync_block_signees.erase( signees_iter );
+    }
+
+    void node_impl::drop_unneeded_sync_block_signees()
+    {
+      VERIFY_CORRECT_THREAD();
+      if( _sync_block_signees.empty() )
+        return;
+
+      std::unordered_set<item_hash_t> still_needed;
+      for( const peer_connection_ptr& peer : _active_connections )
+        still_needed.insert( peer->ids_of_items_to_get.begin(), peer->ids_of_items_to_get.end() );
+      // a recovery only uses its own copy of the block, so dropping its future lets it finish unobserved
+      for( auto itr = _sync_block_signees.begin(); itr != _sync_block_signees.end(); )
+        if( still_needed.find( itr->first ) == still_needed.end() )
+          itr = _sync_block_signees.erase( itr );
+        else
+          ++itr;
+    }
+
     void node_impl::process_block_during_normal_operation( peer_connection* originating_peer,
                                                            const graphene::net::block_message& block_message_to_process,
                                                            const message_hash_type& message_hash )
@@ -3864,6 +3967,43 @@ namespace graphene { namespace net { namespace detail {
     }
 
 
+    /**
+     * Drops transactions the client already has, then runs the checks that don't depend on chain
+     * state (operation validation and signature recovery) on the shared worker pool, so transactions
+     * from several peers are checked in parallel instead of on the chain thread.  The recovered keys
+     * are left in the transaction's signees, so the client doesn't recover them again.
+     * @throws fc::exception if the transaction is a duplicate or fails any of the checks
+     */
+    void node_impl::prevalidate_transaction( const std::shared_ptr<graphene::net::trx_message>& transaction_message )
+    {
+      VERIFY_CORRECT_THREAD();
+      const graphene::chain::transaction_id_type trx_id = transaction_message->trx.id();
+      if( _delegate->has_item( item_id( trx_message_type, trx_id ) ) )
+        FC_THROW( "Transaction ${id} is already known", ("id", trx_id) );
+
+      // the worker holds a reference to the message, so it stays valid if this task is canceled
+      const graphene::chain::chain_id_type chain_id = _chain_id;
+      fc::promise<void>::ptr checks_done( new fc::promise<void>("prevalidate_transaction") );
+      graphene::db::thread_pool::shared().run( [transaction_message, chain_id, checks_done]() {
+        try
+        {
+          transaction_message->trx.validate();
+          transaction_message->trx.get_signature_keys( chain_id );
+          checks_done->set_value();
+        }
+        catch( const fc::exception& e )
+        {
+          checks_done->set_exception( e.dynamic_copy_exception() );
+        }
+        catch( const std::exception& e )
+        {
+          checks_done->set_exception( std::make_shared<fc::exception>( FC_LOG_MESSAGE( warn, "${what}", ("what", e.what()) ) ) );
+        }
+      });
+      // only this task waits, the p2p thread keeps reading from the other peers meanwhile
+      fc::future<void>( checks_done ).wait();
+    }
+
     // this handles any message we get that doesn't require any special processing.
     // currently, this is any message other than block messages and p2p-specific
     // messages.  (transaction messages would be handled here, for example)
@@ -3898,9 +4038,10 @@ namespace graphene { namespace net { namespace detail {
         {
           if (message_to_process.msg_type == trx_message_type)
           {
-            trx_message transaction_message_to_process = message_to_process.as<trx_message>();
-            dlog("passing message containing transaction ${trx} to client", ("trx", transaction_message_to_process.trx.id()));
-            _delegate->handle_transaction(transaction_message_to_process);
+            auto transaction_message_to_process = std::make_shared<trx_message>( message_to_process.as<trx_message>() );
+            prevalidate_transaction(transaction_message_to_process);
+            dlog("passing message containing transaction ${trx} to client", ("trx", transaction_message_to_process->trx.id()));
+            _delegate->handle_transaction(*transaction_message_to_process);
           }
           else
             _delegate->handle_message( message_to_process );
@@ -3927,7 +4068,10 @@ namespace graphene { namespace net { namespace detail {
     void node_impl::start_synchronizing_with_peer( const peer_connection_ptr& peer )
     {
       VERIFY_CORRECT_THREAD();
+      bool had_items_to_get = !peer->ids_of_items_to_get.empty();
       peer->ids_of_items_to_get.clear();
+      if( had_items_to_get )
+        drop_unneeded_sync_block_signees();
       peer->number_of_unfetched_item_ids = 0;
       peer->we_need_sync_items_from_peer = true;
       peer->last_block_delegate_has_seen = item_hash_t();
@@ -4072,6 +4216,11 @@ namespace graphene { namespace net { namespace detail {
         }
       }
 
+      // the signature recoveries run on the shared worker pool, don't leave any of them behind
+      for( auto& block_id_and_signees : _sync_block_signees )
+        block_id_and_signees.second.wait();
+      _sync_block_signees.clear();
+
       try
       {
         _fetch_sync_items_loop_done.cancel("node_impl::close()");
@@ -5101,6 +5250,11 @@ namespace graphene { namespace net { namespace detail {
       info["node_public_key"] = fc::variant( _node_public_key, 1 );
       info["node_id"] = fc::variant( _node_id, 1 );
       info["firewalled"] = fc::variant( _is_firewalled, 1 );
+      const message_buffer_pool& buffer_pool = message_buffer_pool::instance();
+      info["message_buffers_allocated"] = fc::variant( buffer_pool.get_buffers_allocated(), 1 );
+      info["message_buffers_reused"] = fc::variant( buffer_pool.get_buffers_reused(), 1 );
+      info["message_bytes_copied"] = fc::variant( buffer_pool.get_bytes_copied(), 1 );
+      info["message_buffer_free_bytes"] = fc::variant( buffer_pool.get_free_bytes(), 1 );
       return info;
     }
     fc::variant_object node_impl::network_get_usage_stats() const
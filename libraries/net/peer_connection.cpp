@@ -45,7 +45,7 @@
 
 namespace graphene { namespace net
   {
-    message peer_connection::real_queued_message::get_message(peer_connection_delegate*)
+    message_frame peer_connection::real_queued_message::get_frame(peer_connection_delegate*)
     {
       if (message_send_time_field_offset != (size_t)-1)
       {
@@ -56,15 +56,15 @@ namespace graphene { namespace net
         memcpy(message_to_send.data.data() + message_send_time_field_offset,
                packed_current_time.data(), packed_current_time.size());
       }
-      return message_to_send;
+      return message_frame::from_message(message_to_send);
     }
     size_t peer_connection::real_queued_message::get_size_in_queue()
     {
       return message_to_send.data.size();
     }
-    message peer_connection::virtual_queued_message::get_message(peer_connection_delegate* node)
+    message_frame peer_connection::virtual_queued_message::get_frame(peer_connection_delegate* node)
     {
-      return node->get_message_for_item(item_to_send);
+      return node->get_frame_for_item(item_to_send);
     }
 
     size_t peer_connection::virtual_queued_message::get_size_in_queue()
@@ -296,13 +296,13 @@ namespace graphene { namespace net
       while (!_queued_messages.empty())
       {
         _queued_messages.front()->transmission_start_time = fc::time_point::now();
-        message message_to_send = _queued_messages.front()->get_message(_node);
+        message_frame frame_to_send = _queued_messages.front()->get_frame(_node);
         try
         {
-          //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_message() "
-          //     "to send message of type ${type} for peer ${endpoint}",
-          //     ("type", message_to_send.msg_type)("endpoint", get_remote_endpoint()));
-          _message_connection.send_message(message_to_send);
+          //dlog("peer_connection::send_queued_messages_task() calling message_oriented_connection::send_frame() "
+          //     "to send ${size} bytes for peer ${endpoint}",
+          //     ("size", frame_to_send.size)("endpoint", get_remote_endpoint()));
+          _message_connection.send_frame(frame_to_send);
           //dlog("peer_connection::send_queued_messages_task()'s call to message_oriented_connection::send_message() completed normally for peer ${endpoint}",
           //     ("endpoint", get_remote_endpoint()));
         }
@@ -33,6 +33,7 @@
 #include <fc/exception/exception.hpp>
 
 #include <graphene/net/stcp_socket.hpp>
+#include <graphene/net/message_buffer_pool.hpp>
 
 namespace graphene { namespace net {
 
@@ -100,26 +101,44 @@ size_t stcp_socket::readsome( char* buffer, size_t len )
     } buffer_in_use_checker(_read_buffer_in_use);
 #endif
 
+    // small reads reuse _read_buffer, larger ones get a pooled buffer so they don't have to be split up
     const size_t read_buffer_length = 4096;
-    if (!_read_buffer)
-      _read_buffer.reset(new char[read_buffer_length], [](char* p){ delete[] p; });
-
-    len = std::min<size_t>(read_buffer_length, len);
+    std::shared_ptr<char> read_buffer;
+    if (len <= read_buffer_length)
+    {
+      if (!_read_buffer)
+        _read_buffer.reset(new char[read_buffer_length], [](char* p){ delete[] p; });
+      read_buffer = _read_buffer;
+    }
+    else
+      read_buffer = message_buffer_pool::instance().get_buffer(len);
 
-    size_t s = _sock.readsome( _read_buffer, len, 0 );
+    size_t s = _sock.readsome( read_buffer, len, 0 );
     if( s % 16 ) 
     {
-      _sock.read(_read_buffer, 16 - (s%16), s);
+      _sock.read(read_buffer, 16 - (s%16), s);
       s += 16-(s%16);
     }
-    _recv_aes.decode( _read_buffer.get(), s, buffer );
+    _recv_aes.decode( read_buffer.get(), s, buffer );
     return s;
 } FC_RETHROW_EXCEPTIONS( warn, "", ("len",len) ) }
 
+/**
+ *  Reads straight into buf and decrypts it there, without going through _read_buffer.
+ */
 size_t stcp_socket::readsome( const std::shared_ptr<char>& buf, size_t len, size_t offset ) 
-{
-  return readsome(buf.get() + offset, len);
-}
+{ try {
+    assert( len > 0 && (len % 16) == 0 );
+
+    size_t s = _sock.readsome( buf, len, offset );
+    if( s % 16 ) 
+    {
+      _sock.read(buf, 16 - (s%16), offset + s);
+      s += 16-(s%16);
+    }
+    _recv_aes.decode( buf.get() + offset, s, buf.get() + offset );
+    return s;
+} FC_RETHROW_EXCEPTIONS( warn, "", ("len",len) ) }
 
 bool stcp_socket::eof()const
 {
@@ -163,6 +182,15 @@ size_t stcp_socket::writesome( const std::shared_ptr<const char>& buf, size_t le
   return writesome(buf.get() + offset, len);
 }
 
+void stcp_socket::write_frame( const std::shared_ptr<const char>& frame, size_t len )
+{ try {
+    assert( len > 0 && (len % 16) == 0 );
+    std::shared_ptr<char> ciphertext = message_buffer_pool::instance().get_buffer( len );
+    uint32_t ciphertext_len = _send_aes.encode( frame.get(), len, ciphertext.get() );
+    assert(ciphertext_len == len);
+    _sock.write( ciphertext, ciphertext_len );
+} FC_RETHROW_EXCEPTIONS( warn, "", ("len",len) ) }
+
 void stcp_socket::flush()
 {
   _sock.flush();
@@ -67,6 +67,7 @@ class account_history_plugin_impl
       bool _partial_operations = false;
       primary_index< simple_index< operation_history_object > >* _oho_index;
       uint32_t _max_ops_per_account = -1;
+      bool _index_operation_types = false;
    private:
       /** add one history record, then check and remove the earliest history record */
       void add_account_history( const account_id_type account_id, const operation_history_id_type op_id );
@@ -260,6 +261,56 @@ void account_history_plugin_impl::add_account_history( const account_id_type acc
 
 } // end namespace detail
 
+void history_by_operation_type_index::object_inserted( const object& obj )
+{
+   const auto& ath = static_cast< const account_transaction_history_object& >( obj );
+   const int operation_type = ath.operation_id(_db).op.which();
+   _entries.insert( entry{ ath.account, operation_type, ath.operation_id } );
+   _operation_types[ath.id] = operation_type;
+}
+
+void history_by_operation_type_index::object_removed( const object& obj )
+{
+   const auto& ath = static_cast< const account_transaction_history_object& >( obj );
+   auto itr = _operation_types.find( ath.id );
+   if( itr == _operation_types.end() ) return;
+   _entries.erase( entry{ ath.account, itr->second, ath.operation_id } );
+   _operation_types.erase( itr );
+}
+
+vector<operation_history_id_type> history_by_operation_type_index::get_operations( account_id_type account,
+                                                                                   const flat_set<int>& operation_types,
+                                                                                   operation_history_id_type start,
+                                                                                   operation_history_id_type stop,
+                                                                                   uint32_t limit )const
+{
+   // one range per operation type, each walked backwards from start; the next result is the
+   // most recent operation among the ends of the ranges
+   typedef std::set<entry>::const_iterator iterator;
+   vector< std::pair<iterator, iterator> > ranges;
+   for( int operation_type : operation_types )
+   {
+      auto first = _entries.upper_bound( entry{ account, operation_type, stop } );
+      auto last = _entries.upper_bound( entry{ account, operation_type, start } );
+      if( first != last )
+         ranges.emplace_back( first, last );
+   }
+
+   vector<operation_history_id_type> result;
+   while( result.size() < limit && !ranges.empty() )
+   {
+      auto next = ranges.begin();
+      for( auto r = ranges.begin() + 1; r != ranges.end(); ++r )
+         if( std::prev( next->second )->operation < std::prev( r->second )->operation )
+            next = r;
+      --next->second;
+      result.push_back( next->second->operation );
+      if( next->first == next->second )
+         ranges.erase( next );
+   }
+   return result;
+}
+
 
 
 
@@ -288,6 +339,8 @@ void account_history_plugin::plugin_set_program_options(
          ("track-account", boost::program_options::value<std::vector<std::string>>()->composing()->multitoken(), "Account ID to track history for (may specify multiple times)")
          ("partial-operations", boost::program_options::value<bool>(), "Keep only those operations in memory that are related to account history tracking")
          ("max-ops-per-account", boost::program_options::value<uint32_t>(), "Maximum number of operations per account will be kept in memory")
+         ("index-operation-types", boost::program_options::value<bool>()->implicit_value(true),
+          "Index account history by operation type, for fast history queries filtered by operation type (default: false)")
          ;
    cfg.add(cli);
 }
@@ -296,7 +349,7 @@ void account_history_plugin::plugin_initialize(const boost::program_options::var
 {
    database().applied_block.connect( [&]( const signed_block& b){ my->update_account_histories(b); } );
    my->_oho_index = database().add_index< primary_index< simple_index< operation_history_object > > >();
-   database().add_index< primary_index< account_transaction_history_index > >();
+   auto ath_index = database().add_index< primary_index< account_transaction_history_index > >();
 
    LOAD_VALUE_SET(options, "track-account", my->_tracked_accounts, graphene::chain::account_id_type);
    if (options.count("partial-operations")) {
@@ -305,6 +358,11 @@ void account_history_plugin::plugin_initialize(const boost::program_options::var
    if (options.count("max-ops-per-account")) {
        my->_max_ops_per_account = options["max-ops-per-account"].as<uint32_t>();
    }
+   if (options.count("index-operation-types")) {
+       my->_index_operation_types = options["index-operation-types"].as<bool>();
+   }
+   if( my->_index_operation_types )
+      ath_index->add_secondary_index<history_by_operation_type_index>( database() );
 }
 
 void account_history_plugin::plugin_startup()
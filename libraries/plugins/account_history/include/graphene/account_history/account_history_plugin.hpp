@@ -30,6 +30,9 @@
 
 #include <fc/thread/future.hpp>
 
+#include <set>
+#include <unordered_map>
+
 namespace graphene { namespace account_history {
    using namespace chain;
    //using namespace graphene::db;
@@ -53,7 +56,8 @@ namespace graphene { namespace account_history {
 enum account_history_object_type
 {
    key_account_object_type = 0,
-   bucket_object_type = 1 ///< used in market_history_plugin
+   bucket_object_type = 1, ///< used in market_history_plugin
+   market_ticker_object_type = 2 ///< used in market_history_plugin
 };
 
 
@@ -92,6 +96,49 @@ class affiliate_reward_index : public secondary_index
       map<account_id_type, set<operation_history_id_type> > _history_by_account;
 };
 
+/**
+ *  @brief Secondary index of account_transaction_history_index ordered by account, operation type and
+ *  operation, maintained when the plugin is started with index-operation-types.
+ */
+class history_by_operation_type_index : public secondary_index
+{
+   public:
+      explicit history_by_operation_type_index( const graphene::chain::database& db ):_db(db){}
+
+      virtual void object_inserted( const object& obj ) override;
+      virtual void object_removed( const object& obj ) override;
+      virtual void about_to_modify( const object& before ) override{};
+      virtual void object_modified( const object& after  ) override{};
+
+      /**
+       *  @return up to limit operations of account that have one of operation_types, most recent first,
+       *  from start down to but excluding stop
+       */
+      vector<operation_history_id_type> get_operations( account_id_type account,
+                                                        const flat_set<int>& operation_types,
+                                                        operation_history_id_type start,
+                                                        operation_history_id_type stop,
+                                                        uint32_t limit )const;
+
+   private:
+      struct entry
+      {
+         account_id_type            account;
+         int                        operation_type;
+         operation_history_id_type  operation;
+
+         friend bool operator < ( const entry& a, const entry& b )
+         {
+            return std::tie( a.account, a.operation_type, a.operation ) < std::tie( b.account, b.operation_type, b.operation );
+         }
+      };
+
+      const graphene::chain::database&                _db;
+      std::set<entry>                                 _entries;
+      /** the operation type of each entry, as the operation may be gone when the entry is removed */
+      std::unordered_map<object_id_type, int>         _operation_types;
+};
+
 } } //graphene::account_history
 
 /*struct by_id;
@@ -24,6 +24,7 @@
 #include <fc/filesystem.hpp>
 #include <fc/optional.hpp>
 #include <fc/variant_object.hpp>
+#include <fc/thread/thread.hpp>
 
 #include <graphene/app/application.hpp>
 
@@ -38,17 +39,23 @@
 #include <graphene/bookie/bookie_api.hpp>
 #include <graphene/bookie/bookie_plugin.hpp>
 #include <graphene/bookie/bookie_objects.hpp>
+#include <graphene/bookie/order_book_index.hpp>
+
+#include <boost/signals2/connection.hpp>
 
 namespace graphene { namespace bookie {
 
 namespace detail {
 
-class bookie_api_impl
+class bookie_api_impl : public std::enable_shared_from_this<bookie_api_impl>
 {
    public:
       bookie_api_impl(graphene::app::application& _app);
 
       binned_order_book get_binned_order_book(graphene::chain::betting_market_id_type betting_market_id, int32_t precision);
+      binned_order_book walk_binned_order_book(graphene::chain::betting_market_id_type betting_market_id, int32_t precision);
+      void subscribe_to_binned_order_book(std::function<void(const variant&)> callback, betting_market_id_type betting_market_id, int32_t precision);
+      void unsubscribe_from_binned_order_book(betting_market_id_type betting_market_id);
       std::shared_ptr<graphene::bookie::bookie_plugin> get_plugin();
       asset get_total_matched_bet_amount_for_betting_market_group(betting_market_group_id_type group_id);
       std::vector<event_object> get_events_containing_sub_string(const std::string& sub_string, const std::string& language);
@@ -56,29 +63,116 @@ class bookie_api_impl
       std::vector<matched_bet_object> get_matched_bets_for_bettor(account_id_type bettor_id) const;
       std::vector<matched_bet_object> get_all_matched_bets_for_bettor(account_id_type bettor_id, bet_id_type start, unsigned limit) const;
       graphene::app::application& app;
+
+   private:
+      struct order_book_subscription
+      {
+         std::function<void(const variant&)> callback;
+         int32_t precision;
+         /** of the exact levels when the book was last sent */
+         uint64_t fingerprint;
+         /** the binned book last sent, the exact levels can change without changing the bins */
+         binned_order_book book;
+      };
+
+      const order_book_index* find_order_book_index() const;
+      void on_applied_block();
+
+      boost::signals2::scoped_connection _applied_block_connection;
+      std::map<betting_market_id_type, order_book_subscription> _order_book_subscriptions;
 };
 
 bookie_api_impl::bookie_api_impl(graphene::app::application& _app) : app(_app)
 {}
 
+const order_book_index* bookie_api_impl::find_order_book_index() const
+{
+   std::shared_ptr<graphene::chain::database> db = app.chain_database();
+   return db->get_index_type<primary_index<bet_object_index> >().find_secondary_index<order_book_index>();
+}
 
 binned_order_book bookie_api_impl::get_binned_order_book(graphene::chain::betting_market_id_type betting_market_id, int32_t precision)
+{
+    const order_book_index* index = find_order_book_index();
+    if (!index) // the bookie plugin is not running
+        return walk_binned_order_book(betting_market_id, precision);
+
+    std::shared_ptr<graphene::chain::database> db = app.chain_database();
+    const chain_parameters& current_params = db->get_global_properties().parameters;
+    return index->get_binned_order_book(betting_market_id, precision,
+                                        current_params.min_bet_multiplier(), current_params.max_bet_multiplier());
+}
+
+void bookie_api_impl::subscribe_to_binned_order_book(std::function<void(const variant&)> callback, betting_market_id_type betting_market_id, int32_t precision)
+{
+   const order_book_index* index = find_order_book_index();
+   FC_ASSERT(index, "Order book subscriptions require the bookie plugin");
+   order_book_index::get_bin_size(precision); // validates the precision
+
+   if (!_applied_block_connection.connected())
+   {
+      std::shared_ptr<graphene::chain::database> db = app.chain_database();
+      _applied_block_connection = db->applied_block.connect([this](const signed_block&){ on_applied_block(); });
+   }
+   _order_book_subscriptions[betting_market_id] = order_book_subscription{ callback, precision, index->get_fingerprint(betting_market_id),
+                                                                           get_binned_order_book(betting_market_id, precision) };
+}
+
+void bookie_api_impl::unsubscribe_from_binned_order_book(betting_market_id_type betting_market_id)
+{
+   _order_book_subscriptions.erase(betting_market_id);
+}
+
+void bookie_api_impl::on_applied_block()
+{
+   if (_order_book_subscriptions.empty())
+      return;
+   const order_book_index* index = find_order_book_index();
+   if (!index)
+      return;
+
+   auto same_bins = [](const std::vector<order_bin>& a, const std::vector<order_bin>& b) {
+      return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](const order_bin& x, const order_bin& y) {
+         return x.amount_to_bet == y.amount_to_bet && x.backer_multiplier == y.backer_multiplier;
+      });
+   };
+
+   std::vector<std::pair<betting_market_id_type, binned_order_book>> changed_order_books;
+   for (auto& subscription : _order_book_subscriptions)
+   {
+      uint64_t fingerprint = index->get_fingerprint(subscription.first);
+      if (fingerprint == subscription.second.fingerprint)
+         continue;
+      subscription.second.fingerprint = fingerprint;
+      binned_order_book book = get_binned_order_book(subscription.first, subscription.second.precision);
+      if (same_bins(book.aggregated_back_bets, subscription.second.book.aggregated_back_bets) &&
+          same_bins(book.aggregated_lay_bets, subscription.second.book.aggregated_lay_bets))
+         continue;
+      subscription.second.book = book;
+      changed_order_books.emplace_back(subscription.first, std::move(book));
+   }
+   if (changed_order_books.empty())
+      return;
+
+   /// we need to ensure the bookie_api is not deleted for the life of the async operation
+   auto capture_this = shared_from_this();
+   fc::async([this, capture_this, changed_order_books](){
+      for (const auto& item : changed_order_books)
+      {
+         auto itr = _order_book_subscriptions.find(item.first);
+         if (itr != _order_book_subscriptions.end())
+            itr->second.callback(fc::variant(item, GRAPHENE_MAX_NESTED_OBJECTS));
+      }
+   });
+}
+
+binned_order_book bookie_api_impl::walk_binned_order_book(graphene::chain::betting_market_id_type betting_market_id, int32_t precision)
 {
     std::shared_ptr<graphene::chain::database> db = app.chain_database();
     const auto& bet_odds_idx = db->get_index_type<graphene::chain::bet_object_index>().indices().get<graphene::chain::by_odds>();
     const chain_parameters& current_params = db->get_global_properties().parameters;
 
-    graphene::chain::bet_multiplier_type bin_size = GRAPHENE_BETTING_ODDS_PRECISION;
-    if (precision > 0)
-        for (int32_t i = 0; i < precision; ++i) {
-            FC_ASSERT(bin_size > (GRAPHENE_BETTING_MIN_MULTIPLIER - GRAPHENE_BETTING_ODDS_PRECISION), "invalid precision");
-            bin_size /= 10;
-        }
-    else if (precision < 0)
-        for (int32_t i = 0; i > precision; --i) {
-            FC_ASSERT(bin_size < (GRAPHENE_BETTING_MAX_MULTIPLIER - GRAPHENE_BETTING_ODDS_PRECISION), "invalid precision");
-            bin_size *= 10;
-        }
+    graphene::chain::bet_multiplier_type bin_size = order_book_index::get_bin_size(precision);
 
     binned_order_book result; 
 
@@ -284,6 +378,16 @@ binned_order_book bookie_api::get_binned_order_book(graphene::chain::betting_mar
    return my->get_binned_order_book(betting_market_id, precision);
 }
 
+void bookie_api::subscribe_to_binned_order_book(std::function<void(const variant&)> callback, betting_market_id_type betting_market_id, int32_t precision)
+{
+   my->subscribe_to_binned_order_book(callback, betting_market_id, precision);
+}
+
+void bookie_api::unsubscribe_from_binned_order_book(betting_market_id_type betting_market_id)
+{
+   my->unsubscribe_from_binned_order_book(betting_market_id);
+}
+
 asset bookie_api::get_total_matched_bet_amount_for_betting_market_group(betting_market_group_id_type group_id)
 {
     return my->get_total_matched_bet_amount_for_betting_market_group(group_id);
@@ -23,6 +23,7 @@
  */
 #include <graphene/bookie/bookie_plugin.hpp>
 #include <graphene/bookie/bookie_objects.hpp>
+#include <graphene/bookie/order_book_index.hpp>
 
 #include <graphene/chain/impacted.hpp>
 
@@ -36,6 +37,9 @@
 
 #include <boost/algorithm/string/case_conv.hpp>
 
+#include <algorithm>
+#include <unordered_map>
+
 #include <fc/thread/thread.hpp>
 
 #include <boost/polymorphic_cast.hpp>
@@ -199,6 +203,90 @@ void persistent_event_object_helper::object_modified(const object& after)
 }
 
 //////////// end event_object ///////////////////
+
+/* Names of the events in one language, lower-cased once when they are added, with a trigram index
+ * over them.  A search for a sub string of three or more bytes only checks the events having the
+ * least common of its trigrams instead of every name.  Works on the bytes of the UTF-8 names, like
+ * std::string::find().
+ */
+class event_name_index
+{
+   public:
+      void set_name(event_id_type event_id, const std::string& name);
+      /** @return the events whose name contains the sub string, by increasing id */
+      std::vector<event_id_type> find(const std::string& sub_string) const;
+
+   private:
+      typedef uint32_t trigram;
+      static trigram get_trigram(const std::string& s, size_t pos)
+      {
+         return (uint32_t(uint8_t(s[pos])) << 16) | (uint32_t(uint8_t(s[pos + 1])) << 8) | uint8_t(s[pos + 2]);
+      }
+      static flat_set<trigram> get_trigrams(const std::string& s);
+
+      std::map<event_id_type, std::string> _lower_case_names;
+      std::unordered_map<trigram, flat_set<event_id_type>> _events_by_trigram;
+};
+
+flat_set<event_name_index::trigram> event_name_index::get_trigrams(const std::string& s)
+{
+   flat_set<trigram> trigrams;
+   for (size_t pos = 0; pos + 3 <= s.size(); ++pos)
+      trigrams.insert(get_trigram(s, pos));
+   return trigrams;
+}
+
+void event_name_index::set_name(event_id_type event_id, const std::string& name)
+{
+   std::string& lower_case_name = _lower_case_names[event_id];
+   for (trigram t : get_trigrams(lower_case_name))
+   {
+      auto itr = _events_by_trigram.find(t);
+      itr->second.erase(event_id);
+      if (itr->second.empty())
+         _events_by_trigram.erase(itr);
+   }
+   lower_case_name = boost::algorithm::to_lower_copy(name);
+   for (trigram t : get_trigrams(lower_case_name))
+      _events_by_trigram[t].insert(event_id);
+}
+
+std::vector<event_id_type> event_name_index::find(const std::string& sub_string) const
+{
+   std::vector<event_id_type> result;
+   const std::string lower_case_sub_string = boost::algorithm::to_lower_copy(sub_string);
+   if (lower_case_sub_string.size() < 3)
+   {
+      for (const auto& name : _lower_case_names)
+         if (name.second.find(lower_case_sub_string) != std::string::npos)
+            result.push_back(name.first);
+      return result;
+   }
+
+   // every trigram of the sub string must be in the name; walk the shortest list and check the others
+   std::vector<const flat_set<event_id_type>*> candidates;
+   for (trigram t : get_trigrams(lower_case_sub_string))
+   {
+      auto itr = _events_by_trigram.find(t);
+      if (itr == _events_by_trigram.end())
+         return result;
+      candidates.push_back(&itr->second);
+   }
+   std::sort(candidates.begin(), candidates.end(), [](const flat_set<event_id_type>* a, const flat_set<event_id_type>* b) {
+      return a->size() < b->size();
+   });
+   for (event_id_type event_id : *candidates.front())
+   {
+      bool has_all_trigrams = std::all_of(candidates.begin() + 1, candidates.end(), [event_id](const flat_set<event_id_type>* events) {
+         return events->count(event_id) != 0;
+      });
+      // the trigrams may be in the name in another order
+      if (has_all_trigrams && _lower_case_names.at(event_id).find(lower_case_sub_string) != std::string::npos)
+         result.push_back(event_id);
+   }
+   return result;
+}
+
 class bookie_plugin_impl
 {
    public:
@@ -233,19 +321,8 @@ class bookie_plugin_impl
          return _self.database();
       }
 
-      //                1.18.          "Washington Capitals/Chicago Blackhawks"
-      typedef std::pair<event_id_type, std::string> event_string;
-      struct event_string_less : public std::less<const event_string&>
-      {
-          bool operator()(const event_string &_left, const event_string &_right) const
-          {
-              return (_left.first.instance < _right.first.instance);
-          }
-      };
-
-      typedef flat_set<event_string, event_string_less> event_string_set;
       //       "en"
-      std::map<std::string, event_string_set> localized_event_strings;
+      std::map<std::string, event_name_index> localized_event_strings;
 
       bookie_plugin& _self;
       flat_set<account_id_type> _tracked_accounts;
@@ -343,7 +420,7 @@ void bookie_plugin_impl::on_block_applied( const signed_block& )
          FC_ASSERT( db.find_object(object_id), "invalid event specified" );
          const event_create_operation& event_create_op = op.op.get<event_create_operation>();
          for(const std::pair<std::string, std::string>& pair : event_create_op.name)
-            localized_event_strings[pair.first].insert(event_string(object_id, pair.second));
+            localized_event_strings[pair.first].set_name(object_id, pair.second);
       }
       else if( op.op.which() == operation::tag<event_update_operation>::value )
       {
@@ -352,14 +429,7 @@ void bookie_plugin_impl::on_block_applied( const signed_block& )
             continue;
          event_id_type event_id = event_create_op.event_id;
          for(const std::pair<std::string, std::string>& pair : *event_create_op.new_name)
-         {
-            // try insert
-            std::pair<event_string_set::iterator, bool> result =
-               localized_event_strings[pair.first].insert(event_string(event_id, pair.second));
-            if (!result.second)
-               //  update string only
-               result.first->second = pair.second;
-         }
+            localized_event_strings[pair.first].set_name(event_id, pair.second);
       }
       else if ( op.op.which() == operation::tag<bet_canceled_operation>::value )
       {
@@ -399,17 +469,14 @@ void bookie_plugin_impl::on_block_applied( const signed_block& )
 
 void bookie_plugin_impl::fill_localized_event_strings()
 {
+       // the persistent events include the events that were settled and removed from the database
        graphene::chain::database& db = database();
-       const auto& event_index = db.get_index_type<event_object_index>().indices().get<by_id>();
-       auto event_itr = event_index.cbegin();
-       while (event_itr != event_index.cend())
+       const auto& persistent_events_by_event_id = db.get_index_type<persistent_event_index>().indices().get<by_event_id>();
+       for (const persistent_event_object& persistent_event_obj : persistent_events_by_event_id)
        {
-           const event_object& event_obj = *event_itr;
-           ++event_itr;
+           const event_object& event_obj = persistent_event_obj.ephemeral_event_object;
            for(const std::pair<std::string, std::string>& pair : event_obj.name)
-           {
-                localized_event_strings[pair.first].insert(event_string(event_obj.id, pair.second));
-           }
+                localized_event_strings[pair.first].set_name(event_obj.id, pair.second);
        }
 }
 
@@ -417,15 +484,21 @@ std::vector<event_object> bookie_plugin_impl::get_events_containing_sub_string(c
 {
    graphene::chain::database& db = database();
    std::vector<event_object> events;
-   if (localized_event_strings.find(language) != localized_event_strings.end())
+   auto language_itr = localized_event_strings.find(language);
+   if (language_itr != localized_event_strings.end())
    {
-      std::string lower_case_sub_string = boost::algorithm::to_lower_copy(sub_string);
-      const event_string_set& language_set = localized_event_strings[language];
-      for (const event_string& pair : language_set)
+      const auto& persistent_events_by_event_id = db.get_index_type<persistent_event_index>().indices().get<by_event_id>();
+      for (event_id_type event_id : language_itr->second.find(sub_string))
       {
-         std::string lower_case_string = boost::algorithm::to_lower_copy(pair.second);
-         if (lower_case_string.find(lower_case_sub_string) != std::string::npos)
-            events.push_back(pair.first(db));
+         const event_object* event_obj = db.find(event_id);
+         if (event_obj)
+            events.push_back(*event_obj);
+         else
+         {
+            auto iter = persistent_events_by_event_id.find(event_id);
+            if (iter != persistent_events_by_event_id.end())
+               events.push_back(iter->ephemeral_event_object);
+         }
       }
    }
    return events;
@@ -482,6 +555,7 @@ void bookie_plugin::plugin_initialize(const boost::program_options::variables_ma
     primary_index<bet_object_index>& nonconst_bet_object_idx = const_cast<primary_index<bet_object_index>&>(bet_object_idx);
     detail::persistent_bet_object_helper* persistent_bet_object_helper_index = nonconst_bet_object_idx.add_secondary_index<detail::persistent_bet_object_helper>();
     persistent_bet_object_helper_index->set_plugin_instance(this);
+    nonconst_bet_object_idx.add_secondary_index<order_book_index>();
 
     const primary_index<betting_market_object_index>& betting_market_object_idx = database().get_index_type<primary_index<betting_market_object_index> >();
     primary_index<betting_market_object_index>& nonconst_betting_market_object_idx = const_cast<primary_index<betting_market_object_index>&>(betting_market_object_idx);
@@ -23,6 +23,7 @@
  */
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -88,6 +89,17 @@ class bookie_api
        * precision = 2 would bin on (1 - 1.01], (1.01 - 1.02]
        */
       binned_order_book get_binned_order_book(graphene::chain::betting_market_id_type betting_market_id, int32_t precision);
+
+      /**
+       * Request notification when the order book of a betting market changes.
+       * After each block that changed the order book, the callback is passed a variant containing the
+       * betting market id and the order book binned according to the given precision, as
+       * returned by get_binned_order_book.  Subscribing again to the same betting market replaces the
+       * previous subscription.
+       */
+      void subscribe_to_binned_order_book(std::function<void(const variant&)> callback,
+                                          graphene::chain::betting_market_id_type betting_market_id, int32_t precision);
+      void unsubscribe_from_binned_order_book(graphene::chain::betting_market_id_type betting_market_id);
       asset get_total_matched_bet_amount_for_betting_market_group(betting_market_group_id_type group_id);
       std::vector<event_object> get_events_containing_sub_string(const std::string& sub_string, const std::string& language);
       fc::variants get_objects(const vector<object_id_type>& ids)const;
@@ -104,6 +116,8 @@ FC_REFLECT(graphene::bookie::matched_bet_object, (id)(bettor_id)(betting_market_
 
 FC_API(graphene::bookie::bookie_api,
        (get_binned_order_book)
+       (subscribe_to_binned_order_book)
+       (unsubscribe_from_binned_order_book)
        (get_total_matched_bet_amount_for_betting_market_group)
        (get_events_containing_sub_string)
        (get_objects)
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+
+#include <array>
+#include <map>
+
+#include <graphene/chain/betting_market_object.hpp>
+#include <graphene/bookie/bookie_api.hpp>
+
+namespace graphene { namespace bookie {
+using namespace chain;
+
+/**
+ *  @brief Secondary index on bet_object keeping the order book of every betting market aggregated by odds
+ *
+ *  The amounts are kept at the exact odds and binned for every precision get_bin_size() accepts, so
+ *  get_binned_order_book() only walks price levels, never bets.  Like the by_odds walk it replaces, only
+ *  the bets on the books count; bets still waiting for their delay do not.  A market is dropped once its
+ *  book is empty, e.g. when its bets are canceled or settled before the market is removed.
+ */
+class order_book_index : public secondary_index
+{
+   public:
+      virtual void object_inserted( const object& obj ) override;
+      virtual void object_removed( const object& obj ) override;
+      virtual void about_to_modify( const object& before ) override;
+      virtual void object_modified( const object& after  ) override;
+
+      /**
+       *  @return the order book of the market binned according to the given precision, with the bins
+       *  clamped to the given range of multipliers
+       */
+      binned_order_book get_binned_order_book( betting_market_id_type betting_market_id, int32_t precision,
+                                               bet_multiplier_type min_multiplier, bet_multiplier_type max_multiplier )const;
+
+      /**
+       *  @return a hash of the price levels of the market, 0 for an empty book; it only changes when the
+       *  levels do, so a bet placed and canceled again, or applied and undone, leaves it as it was
+       */
+      uint64_t get_fingerprint( betting_market_id_type betting_market_id )const;
+
+      /** @return the size of the bins for the given precision, throws if the precision is out of range */
+      static bet_multiplier_type get_bin_size( int32_t precision );
+
+      /** the range of precisions accepted by get_bin_size() */
+      static const int32_t min_precision = -4;
+      static const int32_t max_precision = 4;
+
+   private:
+      /** amounts to bet by multiplier */
+      typedef std::map<bet_multiplier_type, share_type> price_levels;
+
+      struct market_book
+      {
+         price_levels back_levels;
+         price_levels lay_levels;
+         /** back and lay bins by precision, starting at min_precision */
+         std::array<std::pair<price_levels, price_levels>, max_precision - min_precision + 1> bins;
+         uint64_t fingerprint = 0;
+      };
+
+      void adjust( const bet_object& bet, share_type amount );
+
+      std::map<betting_market_id_type, market_book> _books;
+};
+
+} } // graphene::bookie
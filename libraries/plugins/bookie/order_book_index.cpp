@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/bookie/order_book_index.hpp>
+
+namespace graphene { namespace bookie {
+
+namespace {
+
+/** for back bets, the bets with odds from 3.0001 to 4 go into the "4" bin,
+ *  for lay bets, the bets with odds from 3 to 3.9999 go into the "3" bin */
+bet_multiplier_type get_bin( bet_type back_or_lay, bet_multiplier_type backer_multiplier, bet_multiplier_type bin_size )
+{
+   if( back_or_lay == bet_type::back )
+      return (backer_multiplier + bin_size - 1) / bin_size * bin_size;
+   return backer_multiplier / bin_size * bin_size;
+}
+
+/** @return the amount at backer_multiplier after adding amount to it */
+share_type add_to_level( std::map<bet_multiplier_type, share_type>& levels, bet_multiplier_type backer_multiplier, share_type amount )
+{
+   auto itr = levels.emplace( backer_multiplier, share_type() ).first;
+   itr->second += amount;
+   const share_type result = itr->second;
+   if( result == 0 )
+      levels.erase( itr );
+   return result;
+}
+
+/** spreads the bits of x over the whole result, see splitmix64 */
+uint64_t mix( uint64_t x )
+{
+   x += UINT64_C(0x9e3779b97f4a7c15);
+   x = (x ^ (x >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+   x = (x ^ (x >> 27)) * UINT64_C(0x94d049bb133111eb);
+   return x ^ (x >> 31);
+}
+
+/** the fingerprint of a book is the sum of the hashes of its nonempty levels */
+uint64_t level_hash( bet_type back_or_lay, bet_multiplier_type backer_multiplier, share_type amount )
+{
+   if( amount == 0 )
+      return 0;
+   const uint64_t level = (uint64_t(backer_multiplier) << 1) | (back_or_lay == bet_type::back ? 1 : 0);
+   return mix( mix( level ) ^ uint64_t(amount.value) );
+}
+
+} // end anonymous namespace
+
+bet_multiplier_type order_book_index::get_bin_size( int32_t precision )
+{
+   bet_multiplier_type bin_size = GRAPHENE_BETTING_ODDS_PRECISION;
+   if (precision > 0)
+      for (int32_t i = 0; i < precision; ++i) {
+         FC_ASSERT(bin_size > (GRAPHENE_BETTING_MIN_MULTIPLIER - GRAPHENE_BETTING_ODDS_PRECISION), "invalid precision");
+         bin_size /= 10;
+      }
+   else if (precision < 0)
+      for (int32_t i = 0; i > precision; --i) {
+         FC_ASSERT(bin_size < (GRAPHENE_BETTING_MAX_MULTIPLIER - GRAPHENE_BETTING_ODDS_PRECISION), "invalid precision");
+         bin_size *= 10;
+      }
+   return bin_size;
+}
+
+void order_book_index::adjust( const bet_object& bet, share_type amount )
+{
+   if( bet.end_of_delay || amount == 0 ) return;
+   auto book_itr = _books.emplace( bet.betting_market_id, market_book() ).first;
+   market_book& book = book_itr->second;
+
+   const share_type new_amount = add_to_level( bet.back_or_lay == bet_type::back ? book.back_levels : book.lay_levels,
+                                               bet.backer_multiplier, amount );
+   book.fingerprint += level_hash( bet.back_or_lay, bet.backer_multiplier, new_amount )
+                     - level_hash( bet.back_or_lay, bet.backer_multiplier, new_amount - amount );
+   for( int32_t precision = min_precision; precision <= max_precision; ++precision )
+   {
+      auto& precision_bins = book.bins[precision - min_precision];
+      auto& bins = bet.back_or_lay == bet_type::back ? precision_bins.first : precision_bins.second;
+      add_to_level( bins, get_bin( bet.back_or_lay, bet.backer_multiplier, get_bin_size( precision ) ), amount );
+   }
+
+   if( book.back_levels.empty() && book.lay_levels.empty() )
+      _books.erase( book_itr );
+}
+
+void order_book_index::object_inserted( const object& obj )
+{
+   const bet_object& bet = static_cast<const bet_object&>( obj );
+   adjust( bet, bet.amount_to_bet.amount );
+}
+
+void order_book_index::object_removed( const object& obj )
+{
+   const bet_object& bet = static_cast<const bet_object&>( obj );
+   adjust( bet, -bet.amount_to_bet.amount );
+}
+
+void order_book_index::about_to_modify( const object& before )
+{
+   object_removed( before );
+}
+
+void order_book_index::object_modified( const object& after )
+{
+   object_inserted( after );
+}
+
+binned_order_book order_book_index::get_binned_order_book( betting_market_id_type betting_market_id, int32_t precision,
+                                                           bet_multiplier_type min_multiplier, bet_multiplier_type max_multiplier )const
+{
+   get_bin_size( precision ); // validates the precision
+   binned_order_book result;
+   auto book_itr = _books.find( betting_market_id );
+   if( book_itr == _books.end() )
+      return result;
+   const auto& bins = book_itr->second.bins[precision - min_precision];
+
+   // backs at increasing odds, lays at decreasing odds; bins beyond the allowed odds are merged into the last one
+   for( const auto& bin : bins.first )
+   {
+      bet_multiplier_type backer_multiplier = std::min( bin.first, max_multiplier );
+      if( !result.aggregated_back_bets.empty() && result.aggregated_back_bets.back().backer_multiplier == backer_multiplier )
+         result.aggregated_back_bets.back().amount_to_bet += bin.second;
+      else
+         result.aggregated_back_bets.emplace_back( order_bin{ bin.second, backer_multiplier } );
+   }
+   for( auto itr = bins.second.rbegin(); itr != bins.second.rend(); ++itr )
+   {
+      bet_multiplier_type backer_multiplier = std::max( itr->first, min_multiplier );
+      if( !result.aggregated_lay_bets.empty() && result.aggregated_lay_bets.back().backer_multiplier == backer_multiplier )
+         result.aggregated_lay_bets.back().amount_to_bet += itr->second;
+      else
+         result.aggregated_lay_bets.emplace_back( order_bin{ itr->second, backer_multiplier } );
+   }
+   return result;
+}
+
+uint64_t order_book_index::get_fingerprint( betting_market_id_type betting_market_id )const
+{
+   auto itr = _books.find( betting_market_id );
+   return itr == _books.end() ? 0 : itr->second.fingerprint;
+}
+
+} } // graphene::bookie
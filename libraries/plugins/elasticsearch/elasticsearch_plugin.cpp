@@ -26,6 +26,8 @@
 #include <graphene/chain/impacted.hpp>
 #include <graphene/chain/account_evaluator.hpp>
 #include <graphene/chain/hardfork.hpp>
+#include <graphene/utilities/elasticsearch_exporter.hpp>
+#include <boost/filesystem/path.hpp>
 #include <curl/curl.h>
 
 namespace graphene { namespace elasticsearch {
@@ -61,12 +63,14 @@ class elasticsearch_plugin_impl
       uint32_t _elasticsearch_start_es_after_block = 0;
       bool _elasticsearch_operation_string = true;
       mode _elasticsearch_mode = mode::only_save;
+      fc::path _elasticsearch_spool_dir;
+      bool _elasticsearch_compress_bulk = true;
       CURL *curl; // curl handler
-      vector <string> bulk_lines; //  vector of op lines
+      vector <string> bulk_lines; //  vector of op lines of the current block
       vector<std::string> prepare;
 
-      graphene::utilities::ES es;
-      uint32_t limit_documents;
+      /// sends the bulk lines from its own thread, so applying blocks never waits on elasticsearch
+      std::unique_ptr<graphene::utilities::elasticsearch_exporter> exporter;
       int16_t op_type;
       operation_history_struct os;
       block_struct bs;
@@ -74,8 +78,6 @@ class elasticsearch_plugin_impl
       bulk_struct bulk_line_struct;
       std::string bulk_line;
       std::string index_name;
-      bool is_sync = false;
-      fc::time_point last_sync;
    private:
       bool add_elasticsearch( const account_id_type account_id, const optional<operation_history_object>& oho, const uint32_t block_number );
       const account_transaction_history_object& addNewEntry(const account_statistics_object& stats_obj,
@@ -87,15 +89,14 @@ class elasticsearch_plugin_impl
       void doOperationHistory(const optional <operation_history_object>& oho);
       void doBlock(const optional <operation_history_object>& oho, const signed_block& b);
       void doVisitor(const optional <operation_history_object>& oho);
-      void checkState(const fc::time_point_sec& block_time);
       void cleanObjects(const account_transaction_history_object& ath, account_id_type account_id);
       void createBulkLine(const account_transaction_history_object& ath);
       void prepareBulk(const account_transaction_history_id_type& ath_id);
-      void populateESstruct();
 };
 
 elasticsearch_plugin_impl::~elasticsearch_plugin_impl()
 {
+   exporter.reset();
    if (curl) {
       curl_easy_cleanup(curl);
       curl = nullptr;
@@ -105,7 +106,6 @@ elasticsearch_plugin_impl::~elasticsearch_plugin_impl()
 
 bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b )
 {
-   checkState(b.timestamp);
    index_name = graphene::utilities::generateIndexName(b.timestamp, _elasticsearch_index_prefix);
 
    graphene::chain::database& db = database();
@@ -177,39 +177,13 @@ bool elasticsearch_plugin_impl::update_account_histories( const signed_block& b
             return false;
       }
    }
-   // we send bulk at end of block when we are in sync for better real time client experience
-   if(is_sync)
-   {
-      populateESstruct();
-      if(es.bulk_lines.size() > 0)
-      {
-         prepare.clear();
-         if(!graphene::utilities::SendBulk(es))
-            return false;
-         else
-            bulk_lines.clear();
-      }
-   }
+   // the exporter batches the documents of consecutive blocks on its own
+   exporter->add_block(b.block_num(), bulk_lines);
+   bulk_lines.clear();
 
    return true;
 }
 
-void elasticsearch_plugin_impl::checkState(const fc::time_point_sec& block_time)
-{
-   fc::time_point current_time(fc::time_point::now());
-   if(((current_time - block_time) < fc::seconds(30)) || (current_time - last_sync > fc::seconds(60)))
-   {
-      limit_documents = _elasticsearch_bulk_sync;
-      is_sync = true;
-      last_sync = current_time;
-   }
-   else
-   {
-      limit_documents = _elasticsearch_bulk_replay;
-      is_sync = false;
-   }
-}
-
 void elasticsearch_plugin_impl::getOperationType(const optional <operation_history_object>& oho)
 {
    if (!oho->id.is_null())
@@ -278,15 +252,6 @@ bool elasticsearch_plugin_impl::add_elasticsearch( const account_id_type account
    }
    cleanObjects(ath, account_id);
 
-   if (curl && bulk_lines.size() >= limit_documents) { // we are in bulk time, ready to add data to elasticsearech
-      prepare.clear();
-      populateESstruct();
-      if(!graphene::utilities::SendBulk(es))
-         return false;
-      else
-         bulk_lines.clear();
-   }
-
    return true;
 }
 
@@ -374,14 +339,6 @@ void elasticsearch_plugin_impl::cleanObjects(const account_transaction_history_o
    }
 }
 
-void elasticsearch_plugin_impl::populateESstruct()
-{
-   es.curl = curl;
-   es.bulk_lines = bulk_lines;
-   es.elasticsearch_url = _elasticsearch_node_url;
-   es.auth = _elasticsearch_basic_auth;
-}
-
 } // end namespace detail
 
 elasticsearch_plugin::elasticsearch_plugin() :
@@ -411,9 +368,9 @@ void elasticsearch_plugin::plugin_set_program_options(
          ("elasticsearch-node-url", boost::program_options::value<std::string>(),
                "Elastic Search database node url(http://localhost:9200/)")
          ("elasticsearch-bulk-replay", boost::program_options::value<uint32_t>(),
-               "Number of bulk documents to index on replay(10000)")
+               "Maximum number of bulk documents to index in one request(10000)")
          ("elasticsearch-bulk-sync", boost::program_options::value<uint32_t>(),
-               "Number of bulk documents to index on a syncronied chain(100)")
+               "Unused, documents are sent as soon as they are spooled")
          ("elasticsearch-visitor", boost::program_options::value<bool>(),
                "Use visitor to index additional data(slows down the replay(false))")
          ("elasticsearch-basic-auth", boost::program_options::value<std::string>(),
@@ -428,6 +385,10 @@ void elasticsearch_plugin::plugin_set_program_options(
                "Save operation as string. Needed to serve history api calls(true)")
          ("elasticsearch-mode", boost::program_options::value<uint16_t>(),
                "Mode of operation: only_save(0), only_query(1), all(2) - Default: 0")
+         ("elasticsearch-spool-dir", boost::program_options::value<boost::filesystem::path>(),
+               "Directory where documents are kept until elasticsearch accepts them(data-dir/elasticsearch_spool)")
+         ("elasticsearch-compress-bulk", boost::program_options::value<bool>(),
+               "Send bulk requests gzip compressed(true)")
          ;
    cfg.add(cli);
 }
@@ -470,11 +431,31 @@ void elasticsearch_plugin::plugin_initialize(const boost::program_options::varia
          FC_THROW_EXCEPTION(fc::exception, "Elasticsearch mode not valid");
       my->_elasticsearch_mode = static_cast<mode>(options["elasticsearch-mode"].as<uint16_t>());
    }
+   if (options.count("elasticsearch-spool-dir")) {
+      my->_elasticsearch_spool_dir = options["elasticsearch-spool-dir"].as<boost::filesystem::path>();
+   }
+   else if (options.count("data-dir")) {
+      my->_elasticsearch_spool_dir = options["data-dir"].as<boost::filesystem::path>() / "elasticsearch_spool";
+   }
+   if (options.count("elasticsearch-compress-bulk")) {
+      my->_elasticsearch_compress_bulk = options["elasticsearch-compress-bulk"].as<bool>();
+   }
 
    if(my->_elasticsearch_mode != mode::only_query) {
       if (my->_elasticsearch_mode == mode::all && !my->_elasticsearch_operation_string)
          FC_THROW_EXCEPTION(fc::exception,
                "If elasticsearch-mode is set to all then elasticsearch-operation-string need to be true");
+      if (my->_elasticsearch_spool_dir.string().empty())
+         FC_THROW_EXCEPTION(fc::exception,
+               "Either elasticsearch-spool-dir or data-dir need to be set to store elasticsearch documents");
+
+      graphene::utilities::elasticsearch_exporter::settings exporter_settings;
+      exporter_settings.elasticsearch_url = my->_elasticsearch_node_url;
+      exporter_settings.auth = my->_elasticsearch_basic_auth;
+      exporter_settings.spool_dir = my->_elasticsearch_spool_dir;
+      exporter_settings.max_batch_documents = my->_elasticsearch_bulk_replay;
+      exporter_settings.compress = my->_elasticsearch_compress_bulk;
+      my->exporter.reset(new graphene::utilities::elasticsearch_exporter(exporter_settings));
 
       database().applied_block.connect([this](const signed_block &b) {
          if (!my->update_account_histories(b))
@@ -28,6 +28,8 @@
 
 #include <fc/thread/future.hpp>
 
+#include <boost/multi_index/composite_key.hpp>
+
 namespace graphene { namespace market_history {
 using namespace chain;
 
@@ -106,7 +108,73 @@ struct order_history_object : public abstract_object<order_history_object>
   fill_order_operation op;
 };
 
+/** trades of one market within one interval of market_ticker_object::bucket_seconds */
+struct ticker_bucket
+{
+   fc::time_point_sec  open;
+   share_type          base_volume;
+   share_type          quote_volume;
+   share_type          close_base;
+   share_type          close_quote;
+};
+
+/**
+ *  Rolling 24 hour summary of a market, updated with every fill so that tickers do not
+ *  need to scan the trade history.  Trades are grouped into buckets of bucket_seconds,
+ *  which are dropped from the totals once all of their trades are older than
+ *  window_seconds.  base is always the asset with the lower ID.
+ */
+struct market_ticker_object : public abstract_object<market_ticker_object>
+{
+   static const uint8_t space_id = ACCOUNT_HISTORY_SPACE_ID;
+   static const uint8_t type_id  = 2; // market_history_plugin type, referenced from account_history_plugin.hpp
+
+   static const uint32_t bucket_seconds = 300;
+   static const uint32_t window_seconds = 86400;
+
+   asset_id_type           base;
+   asset_id_type           quote;
+   /** the last trade */
+   share_type              latest_base;
+   share_type              latest_quote;
+   /** the last trade that is no longer within the window, zero if there is none */
+   share_type              last_day_base;
+   share_type              last_day_quote;
+   /** sums over buckets */
+   share_type              base_volume;
+   share_type              quote_volume;
+   vector<ticker_bucket>   buckets;
+   /** when the oldest bucket leaves the window */
+   fc::time_point_sec      expiration = fc::time_point_sec::maximum();
+
+   /** removes the buckets that have left the window at now from the totals */
+   void expire( fc::time_point_sec now )
+   {
+      auto itr = buckets.begin();
+      while( itr != buckets.end() && itr->open + (bucket_seconds + window_seconds) <= now )
+      {
+         base_volume -= itr->base_volume;
+         quote_volume -= itr->quote_volume;
+         last_day_base = itr->close_base;
+         last_day_quote = itr->close_quote;
+         ++itr;
+      }
+      buckets.erase( buckets.begin(), itr );
+      update_expiration();
+   }
+
+   void update_expiration()
+   {
+      if( buckets.empty() )
+         expiration = fc::time_point_sec::maximum();
+      else
+         expiration = buckets.front().open + (bucket_seconds + window_seconds);
+   }
+};
+
 struct by_key;
+struct by_market;
+struct by_expiration;
 typedef multi_index_container<
    bucket_object,
    indexed_by<
@@ -124,8 +192,23 @@ typedef multi_index_container<
 > order_history_multi_index_type;
 
 
+typedef multi_index_container<
+   market_ticker_object,
+   indexed_by<
+      ordered_unique< tag<by_id>, member< object, object_id_type, &object::id > >,
+      ordered_unique< tag<by_market>,
+         composite_key< market_ticker_object,
+            member< market_ticker_object, asset_id_type, &market_ticker_object::base >,
+            member< market_ticker_object, asset_id_type, &market_ticker_object::quote >
+         >
+      >,
+      ordered_non_unique< tag<by_expiration>, member< market_ticker_object, fc::time_point_sec, &market_ticker_object::expiration > >
+   >
+> market_ticker_multi_index_type;
+
 typedef generic_index<bucket_object, bucket_object_multi_index_type> bucket_index;
 typedef generic_index<order_history_object, order_history_multi_index_type> history_index;
+typedef generic_index<market_ticker_object, market_ticker_multi_index_type> market_ticker_index;
 
 
 namespace detail
@@ -172,4 +255,11 @@ FC_REFLECT_DERIVED( graphene::market_history::bucket_object, (graphene::db::obje
                     (open_base)(open_quote)
                     (close_base)(close_quote)
                     (base_volume)(quote_volume) )
+FC_REFLECT( graphene::market_history::ticker_bucket, (open)(base_volume)(quote_volume)(close_base)(close_quote) )
+FC_REFLECT_DERIVED( graphene::market_history::market_ticker_object, (graphene::db::object),
+                    (base)(quote)
+                    (latest_base)(latest_quote)
+                    (last_day_base)(last_day_quote)
+                    (base_volume)(quote_volume)
+                    (buckets)(expiration) )
 
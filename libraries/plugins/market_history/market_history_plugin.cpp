@@ -52,6 +52,11 @@ class market_history_plugin_impl
        */
       void update_market_histories( const signed_block& b );
 
+      /** adds a fill to the ticker of its market */
+      void update_ticker( const fill_order_operation& o, fc::time_point_sec now );
+      /** drops trades older than the ticker window from all tickers */
+      void expire_tickers( fc::time_point_sec now );
+
       graphene::chain::database& database()
       {
          return _self.database();
@@ -215,18 +220,69 @@ market_history_plugin_impl::~market_history_plugin_impl()
 
 void market_history_plugin_impl::update_market_histories( const signed_block& b )
 {
-   if( _maximum_history_per_bucket_size == 0 ) return;
-   if( _tracked_buckets.size() == 0 ) return;
+   expire_tickers( b.timestamp );
+
+   const bool track_buckets = _maximum_history_per_bucket_size != 0 && _tracked_buckets.size() != 0;
 
    graphene::chain::database& db = database();
    const vector<optional< operation_history_object > >& hist = db.get_applied_operations();
    for( const optional< operation_history_object >& o_op : hist )
    {
-      if( o_op.valid() )
+      if( !o_op.valid() ) continue;
+      if( o_op->op.which() == operation::tag<fill_order_operation>::value )
+         update_ticker( o_op->op.get<fill_order_operation>(), b.timestamp );
+      if( track_buckets )
          o_op->op.visit( operation_process_fill_order( _self, b.timestamp ) );
    }
 }
 
+void market_history_plugin_impl::update_ticker( const fill_order_operation& o, fc::time_point_sec now )
+{
+   // every match is reported once for each side, count it like the buckets do
+   if( o.pays.asset_id > o.receives.asset_id )
+      return;
+
+   graphene::chain::database& db = database();
+   const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+   const fc::time_point_sec open( now.sec_since_epoch() - now.sec_since_epoch() % market_ticker_object::bucket_seconds );
+
+   auto add_trade = [&]( market_ticker_object& t ) {
+      t.latest_base = o.pays.amount;
+      t.latest_quote = o.receives.amount;
+      t.base_volume += o.pays.amount;
+      t.quote_volume += o.receives.amount;
+      if( t.buckets.empty() || t.buckets.back().open != open )
+      {
+         t.buckets.emplace_back();
+         t.buckets.back().open = open;
+      }
+      ticker_bucket& bucket = t.buckets.back();
+      bucket.base_volume += o.pays.amount;
+      bucket.quote_volume += o.receives.amount;
+      bucket.close_base = o.pays.amount;
+      bucket.close_quote = o.receives.amount;
+      t.update_expiration();
+   };
+
+   auto itr = ticker_idx.find( boost::make_tuple( o.pays.asset_id, o.receives.asset_id ) );
+   if( itr == ticker_idx.end() )
+      db.create<market_ticker_object>( [&]( market_ticker_object& t ) {
+         t.base = o.pays.asset_id;
+         t.quote = o.receives.asset_id;
+         add_trade( t );
+      });
+   else
+      db.modify( *itr, add_trade );
+}
+
+void market_history_plugin_impl::expire_tickers( fc::time_point_sec now )
+{
+   graphene::chain::database& db = database();
+   const auto& by_exp = db.get_index_type<market_ticker_index>().indices().get<by_expiration>();
+   while( !by_exp.empty() && by_exp.begin()->expiration <= now )
+      db.modify( *by_exp.begin(), [now]( market_ticker_object& t ) { t.expire( now ); } );
+}
+
 } // end namespace detail
 
 
@@ -267,6 +323,7 @@ void market_history_plugin::plugin_initialize(const boost::program_options::vari
    database().applied_block.connect( [this]( const signed_block& b){ my->update_market_histories(b); } );
    database().add_index< primary_index< bucket_index  > >();
    database().add_index< primary_index< history_index  > >();
+   database().add_index< primary_index< market_ticker_index  > >();
 
    if( options.count( "bucket-size" ) )
    {
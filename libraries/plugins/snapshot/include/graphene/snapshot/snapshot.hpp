@@ -25,14 +25,18 @@
 
 #include <graphene/app/plugin.hpp>
 #include <graphene/chain/database.hpp>
+#include <graphene/db/object_snapshot.hpp>
 
 #include <fc/time.hpp>
 
+#include <atomic>
+#include <thread>
+
 namespace graphene { namespace snapshot_plugin {
 
 class snapshot_plugin : public graphene::app::plugin {
    public:
-      ~snapshot_plugin() {}
+      ~snapshot_plugin();
 
       std::string plugin_name()const override;
       std::string plugin_description()const override;
@@ -47,11 +51,27 @@ class snapshot_plugin : public graphene::app::plugin {
       virtual void plugin_shutdown() override;
 
    private:
+       enum class snapshot_format { json, json_gz, binary };
+
        void check_snapshot( const graphene::chain::signed_block& b);
+       void start_snapshot();
+       /** waits for the writer and releases the snapshot, must run on the thread applying blocks */
+       void finish_snapshot();
+       /** runs on the writer thread */
+       void write_snapshot();
+       void write_compressed_json( uint32_t i );
 
        uint32_t           snapshot_block = -1, last_block = 0;
        fc::time_point_sec snapshot_time = fc::time_point_sec::maximum(), last_time = fc::time_point_sec(1);
        fc::path           dest;
+       snapshot_format    format = snapshot_format::json;
+       uint32_t           writer_threads = 0;
+
+       std::unique_ptr<graphene::db::object_snapshot> snapshot;
+       std::thread        writer;
+       std::atomic<bool>  writer_done{false};
+       std::string        writer_error;
+       fc::time_point     writer_start;
 };
 
 } } //graphene::snapshot_plugin
@@ -24,8 +24,16 @@
 #include <graphene/snapshot/snapshot.hpp>
 
 #include <graphene/chain/database.hpp>
+#include <graphene/db/thread_pool.hpp>
 
 #include <fc/io/fstream.hpp>
+#include <fc/io/json.hpp>
+
+#include <boost/iostreams/device/file.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+
+#include <future>
 
 using namespace graphene::snapshot_plugin;
 using std::string;
@@ -36,6 +44,14 @@ namespace bpo = boost::program_options;
 static const char* OPT_BLOCK_NUM  = "snapshot-at-block";
 static const char* OPT_BLOCK_TIME = "snapshot-at-time";
 static const char* OPT_DEST       = "snapshot-to";
+static const char* OPT_FORMAT     = "snapshot-format";
+static const char* OPT_THREADS    = "snapshot-threads";
+
+snapshot_plugin::~snapshot_plugin()
+{
+   if( writer.joinable() )
+      writer.join();
+}
 
 void snapshot_plugin::plugin_set_program_options(
    boost::program_options::options_description& command_line_options,
@@ -44,7 +60,12 @@ void snapshot_plugin::plugin_set_program_options(
    command_line_options.add_options()
          (OPT_BLOCK_NUM, bpo::value<uint32_t>(), "Block number after which to do a snapshot")
          (OPT_BLOCK_TIME, bpo::value<string>(), "Block time (ISO format) after which to do a snapshot")
-         (OPT_DEST, bpo::value<string>(), "Pathname of JSON file where to store the snapshot")
+         (OPT_DEST, bpo::value<string>(), "Pathname of JSON file, or directory for the other formats, where to store the snapshot")
+         (OPT_FORMAT, bpo::value<string>()->default_value("json"),
+          "json: one JSON file, json-gz: one gzipped JSON file per index, "
+          "binary: one file per index in the object database format")
+         (OPT_THREADS, bpo::value<uint32_t>()->default_value(0),
+          "Number of threads writing json-gz or binary snapshots, 0 for one per hardware thread")
          ;
    config_file_options.add(command_line_options);
 }
@@ -71,6 +92,20 @@ void snapshot_plugin::plugin_initialize(const boost::program_options::variables_
          snapshot_block = options[OPT_BLOCK_NUM].as<uint32_t>();
       if( options.count(OPT_BLOCK_TIME) )
          snapshot_time = fc::time_point_sec::from_iso_string( options[OPT_BLOCK_TIME].as<std::string>() );
+      if( options.count(OPT_FORMAT) )
+      {
+         const string f = options[OPT_FORMAT].as<std::string>();
+         if( f == "json" )
+            format = snapshot_format::json;
+         else if( f == "json-gz" )
+            format = snapshot_format::json_gz;
+         else if( f == "binary" )
+            format = snapshot_format::binary;
+         else
+            FC_THROW( "Unknown snapshot-format ${f}, must be json, json-gz or binary", ("f",f) );
+      }
+      if( options.count(OPT_THREADS) )
+         writer_threads = options[OPT_THREADS].as<uint32_t>();
       database().applied_block.connect( [&]( const graphene::chain::signed_block& b ) {
          check_snapshot( b );
       });
@@ -82,47 +117,133 @@ void snapshot_plugin::plugin_initialize(const boost::program_options::variables_
 
 void snapshot_plugin::plugin_startup() {}
 
-void snapshot_plugin::plugin_shutdown() {}
+void snapshot_plugin::plugin_shutdown()
+{
+   if( snapshot )
+   {
+      ilog("snapshot plugin: waiting for the snapshot to be written");
+      finish_snapshot();
+   }
+}
 
-static void create_snapshot( const graphene::chain::database& db, const fc::path& dest )
+void snapshot_plugin::start_snapshot()
 {
-   ilog("snapshot plugin: creating snapshot");
-   fc::ofstream out;
-   try
+   if( format == snapshot_format::json )
    {
-      out.open( dest );
+      fc::ofstream out;
+      try
+      {
+         out.open( dest );
+      }
+      catch ( fc::exception& e )
+      {
+         wlog( "Failed to open snapshot destination: ${ex}", ("ex",e) );
+         return;
+      }
    }
-   catch ( fc::exception& e )
+   else
    {
-      wlog( "Failed to open snapshot destination: ${ex}", ("ex",e) );
-      return;
+      try
+      {
+         fc::create_directories( dest );
+      }
+      catch ( fc::exception& e )
+      {
+         wlog( "Failed to create snapshot directory: ${ex}", ("ex",e) );
+         return;
+      }
    }
-   for( uint32_t space_id = 0; space_id < 256; space_id++ )
-      for( uint32_t type_id = 0; type_id < 256; type_id++ )
+
+   ilog("snapshot plugin: creating snapshot");
+   // only records the objects, they are copied when they change before the writer got to them
+   snapshot.reset( new graphene::db::object_snapshot( database() ) );
+   writer_done = false;
+   writer_error.clear();
+   writer_start = fc::time_point::now();
+   writer = std::thread( [this]() {
+      try
+      {
+         write_snapshot();
+      }
+      catch( const fc::exception& e )
       {
-         try
-         {
-            db.get_index( (uint8_t)space_id, (uint8_t)type_id );
-         }
-         catch (fc::assert_exception& e)
-         {
-            continue;
-         }
-         auto& index = db.get_index( (uint8_t)space_id, (uint8_t)type_id );
-         index.inspect_all_objects( [&out]( const graphene::db::object& o ) {
+         writer_error = e.to_detail_string();
+      }
+      catch( const std::exception& e )
+      {
+         writer_error = e.what();
+      }
+      writer_done = true;
+   });
+}
+
+void snapshot_plugin::finish_snapshot()
+{
+   writer.join();
+   snapshot.reset();
+   if( writer_error.empty() )
+      ilog( "snapshot plugin: created snapshot in ${t} ms", ("t", (fc::time_point::now() - writer_start).count() / 1000) );
+   else
+      elog( "snapshot plugin: failed to create snapshot: ${e}", ("e",writer_error) );
+}
+
+void snapshot_plugin::write_snapshot()
+{
+   if( format == snapshot_format::json )
+   {
+      // a single stream, the indexes are written one after the other
+      fc::ofstream out( dest );
+      for( uint32_t i = 0; i < snapshot->index_count(); ++i )
+         snapshot->inspect_objects( i, [&out]( const graphene::db::object& o ) {
             out << fc::json::to_string( o.to_variant() ) << '\n';
          });
+      out.close();
+      return;
+   }
+
+   graphene::db::thread_pool pool( writer_threads );
+   vector< std::future<void> > results;
+   for( uint32_t i = 0; i < snapshot->index_count(); ++i )
+   {
+      if( format == snapshot_format::binary )
+      {
+         const fc::path dir = dest / std::to_string( uint32_t( snapshot->space_id(i) ) );
+         fc::create_directories( dir );
+         const fc::path file = dir / std::to_string( uint32_t( snapshot->type_id(i) ) );
+         results.push_back( pool.run( [this,i,file]() { snapshot->save_index( i, file ); } ) );
       }
-   out.close();
-   ilog("snapshot plugin: created snapshot");
+      else if( snapshot->object_count(i) > 0 )
+         results.push_back( pool.run( [this,i]() { write_compressed_json( i ); } ) );
+   }
+   for( auto& result : results )
+      result.get();
+}
+
+void snapshot_plugin::write_compressed_json( uint32_t i )
+{
+   const fc::path file = dest / ( std::to_string( uint32_t( snapshot->space_id(i) ) ) + "." + std::to_string( uint32_t( snapshot->type_id(i) ) ) + ".json.gz" );
+   boost::iostreams::filtering_ostream out;
+   out.push( boost::iostreams::gzip_compressor() );
+   out.push( boost::iostreams::file_sink( file.generic_string(), std::ios_base::out | std::ios_base::binary ) );
+   snapshot->inspect_objects( i, [&out]( const graphene::db::object& o ) {
+      out << fc::json::to_string( o.to_variant() ) << '\n';
+   });
+   out.reset();
 }
 
 void snapshot_plugin::check_snapshot( const graphene::chain::signed_block& b )
 { try {
+    if( snapshot && writer_done )
+       finish_snapshot();
     uint32_t current_block = b.block_num();
     if( (last_block < snapshot_block && snapshot_block <= current_block)
            || (last_time < snapshot_time && snapshot_time <= b.timestamp) )
-       create_snapshot( database(), dest );
+    {
+       if( snapshot )
+          wlog( "snapshot plugin: the previous snapshot is still being written, skipping block ${b}", ("b",current_block) );
+       else
+          start_snapshot();
+    }
     last_block = current_block;
     last_time = b.timestamp;
 } FC_LOG_AND_RETHROW() }
@@ -168,6 +168,8 @@ const std::string doCurl(CurlRequest& curl)
    std::string CurlReadBuffer;
    struct curl_slist *headers = NULL;
    headers = curl_slist_append(headers, "Content-Type: application/json");
+   if(!curl.content_encoding.empty())
+      headers = curl_slist_append(headers, ("Content-Encoding: " + curl.content_encoding).c_str());
 
    curl_easy_setopt(curl.handler, CURLOPT_HTTPHEADER, headers);
    curl_easy_setopt(curl.handler, CURLOPT_URL, curl.url.c_str());
@@ -176,6 +178,7 @@ const std::string doCurl(CurlRequest& curl)
    {
       curl_easy_setopt(curl.handler, CURLOPT_POST, true);
       curl_easy_setopt(curl.handler, CURLOPT_POSTFIELDS, curl.query.c_str());
+      curl_easy_setopt(curl.handler, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)curl.query.size());
    }
    curl_easy_setopt(curl.handler, CURLOPT_WRITEFUNCTION, WriteCallback);
    curl_easy_setopt(curl.handler, CURLOPT_WRITEDATA, (void *)&CurlReadBuffer);
@@ -183,6 +186,7 @@ const std::string doCurl(CurlRequest& curl)
    if(!curl.auth.empty())
       curl_easy_setopt(curl.handler, CURLOPT_USERPWD, curl.auth.c_str());
    curl_easy_perform(curl.handler);
+   curl_slist_free_all(headers);
 
    return CurlReadBuffer;
 }
@@ -0,0 +1,412 @@
+/*
+ * Copyright (c) 2018 oxarbitrage, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/utilities/elasticsearch_exporter.hpp>
+#include <graphene/utilities/elasticsearch.hpp>
+
+#include <boost/crc.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/device/back_inserter.hpp>
+
+#include <fc/exception/exception.hpp>
+#include <fc/io/json.hpp>
+#include <fc/log/logger.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+#include <unistd.h>
+
+namespace graphene { namespace utilities {
+
+namespace {
+
+   uint32_t record_checksum( const char* data, size_t size )
+   {
+      boost::crc_32_type crc;
+      crc.process_bytes( data, size );
+      return crc.checksum();
+   }
+
+   void sync_file( std::FILE* f )
+   {
+      std::fflush( f );
+      ::fsync( fileno( f ) );
+   }
+
+}
+
+elasticsearch_exporter::elasticsearch_exporter( const settings& s ) : _settings( s )
+{
+   FC_ASSERT( _settings.max_batch_documents > 0 );
+   open_spool();
+   _sender = std::thread( [this]() { send_loop(); } );
+}
+
+elasticsearch_exporter::~elasticsearch_exporter()
+{
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _stopping = true;
+   }
+   _cv.notify_all();
+   _sender.join();
+
+   if( _writer )
+   {
+      sync_file( _writer );
+      std::fclose( _writer );
+   }
+   if( _reader )
+      std::fclose( _reader );
+}
+
+fc::path elasticsearch_exporter::segment_path( uint64_t segment )const
+{
+   return _settings.spool_dir / ( "segment-" + std::to_string( segment ) );
+}
+
+fc::path elasticsearch_exporter::acknowledged_path()const
+{
+   return _settings.spool_dir / "acknowledged";
+}
+
+void elasticsearch_exporter::open_spool()
+{ try {
+   fc::create_directories( _settings.spool_dir );
+
+   {
+      std::ifstream acknowledged( acknowledged_path().generic_string() );
+      acknowledged >> _acknowledged.segment >> _acknowledged.offset >> _acknowledged_block;
+      if( !acknowledged )
+      {
+         _acknowledged = spool_position();
+         _acknowledged_block = 0;
+      }
+   }
+
+   // segments before the acknowledged one were sent completely
+   std::map<uint64_t, fc::path> segments;
+   for( boost::filesystem::directory_iterator itr( _settings.spool_dir ); itr != boost::filesystem::directory_iterator(); ++itr )
+   {
+      const std::string name = itr->path().filename().string();
+      if( name.compare( 0, 8, "segment-" ) != 0 )
+         continue;
+      const uint64_t segment = std::stoull( name.substr( 8 ) );
+      if( segment < _acknowledged.segment )
+         boost::filesystem::remove( itr->path() );
+      else
+         segments[segment] = itr->path();
+   }
+
+   if( segments.empty() )
+   {
+      _acknowledged.offset = 0;
+      open_segment( _acknowledged.segment );
+   }
+   else
+   {
+      // cut off a record that was only partly written when the node stopped
+      const uint64_t last_segment = segments.rbegin()->first;
+      const std::string last_segment_name = segments.rbegin()->second.generic_string();
+      const uint64_t file_size = boost::filesystem::file_size( last_segment_name );
+      uint64_t valid_size = 0;
+      {
+         std::ifstream in( last_segment_name, std::ios::binary );
+         std::vector<char> data;
+         record_header header;
+         while( valid_size + sizeof(header) <= file_size )
+         {
+            in.read( (char*)&header, sizeof(header) );
+            if( !in || valid_size + sizeof(header) + header.size > file_size )
+               break;
+            data.resize( header.size );
+            in.read( data.data(), header.size );
+            if( !in || record_checksum( data.data(), data.size() ) != header.checksum )
+               break;
+            valid_size += sizeof(header) + header.size;
+         }
+      }
+      if( valid_size < file_size )
+      {
+         wlog( "Removing ${n} bytes of an incomplete record from the end of the elasticsearch spool",
+               ("n", file_size - valid_size) );
+         boost::filesystem::resize_file( last_segment_name, valid_size );
+      }
+      if( _acknowledged.segment == last_segment )
+         _acknowledged.offset = std::min( _acknowledged.offset, valid_size );
+      if( _acknowledged.segment < segments.begin()->first )
+      {
+         _acknowledged.segment = segments.begin()->first;
+         _acknowledged.offset = 0;
+      }
+      open_segment( last_segment );
+   }
+   _written = _write_position;
+   _last_sync = fc::time_point::now();
+   ilog( "elasticsearch spool opened, documents up to block ${b} were already sent", ("b", _acknowledged_block) );
+} FC_CAPTURE_AND_RETHROW( (_settings.spool_dir) ) }
+
+void elasticsearch_exporter::open_segment( uint64_t segment )
+{
+   if( _writer )
+   {
+      sync_file( _writer );
+      std::fclose( _writer );
+   }
+   const std::string name = segment_path( segment ).generic_string();
+   _writer = std::fopen( name.c_str(), "ab" );
+   FC_ASSERT( _writer != nullptr, "Unable to open elasticsearch spool segment ${name}", ("name", name) );
+   _write_position.segment = segment;
+   _write_position.offset = boost::filesystem::file_size( name );
+}
+
+void elasticsearch_exporter::save_acknowledged( const spool_position& pos, uint32_t block_num )
+{
+   const std::string name = acknowledged_path().generic_string();
+   const std::string temp_name = name + ".tmp";
+   std::FILE* f = std::fopen( temp_name.c_str(), "w" );
+   if( f == nullptr )
+   {
+      elog( "Unable to save the elasticsearch spool position to ${name}", ("name", temp_name) );
+      return;
+   }
+   std::fprintf( f, "%llu %llu %u\n", (unsigned long long)pos.segment, (unsigned long long)pos.offset, block_num );
+   sync_file( f );
+   std::fclose( f );
+   boost::filesystem::rename( temp_name, name );
+}
+
+void elasticsearch_exporter::add_block( uint32_t block_num, const std::vector<std::string>& bulk_lines )
+{ try {
+   if( bulk_lines.empty() )
+      return;
+
+   std::string data;
+   size_t data_size = 0;
+   for( const auto& line : bulk_lines )
+      data_size += line.size() + 1;
+   data.reserve( data_size );
+   for( const auto& line : bulk_lines )
+   {
+      data += line;
+      data += '\n';
+   }
+
+   record_header header;
+   header.block_num = block_num;
+   header.line_count = bulk_lines.size();
+   header.size = data.size();
+   header.checksum = record_checksum( data.data(), data.size() );
+
+   if( _write_position.offset > 0 && _write_position.offset + sizeof(header) + data.size() > _settings.segment_size )
+      open_segment( _write_position.segment + 1 );
+
+   FC_ASSERT( std::fwrite( &header, sizeof(header), 1, _writer ) == 1 &&
+              std::fwrite( data.data(), data.size(), 1, _writer ) == 1,
+              "Unable to write to the elasticsearch spool" );
+   // the sender reads the segment through its own handle
+   std::fflush( _writer );
+   _write_position.offset += sizeof(header) + data.size();
+
+   const fc::time_point now = fc::time_point::now();
+   if( now - _last_sync >= _settings.sync_interval )
+   {
+      sync_file( _writer );
+      _last_sync = now;
+   }
+
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      _written = _write_position;
+   }
+   _cv.notify_all();
+} FC_CAPTURE_AND_RETHROW( (block_num) ) }
+
+void elasticsearch_exporter::sync()
+{
+   sync_file( _writer );
+   _last_sync = fc::time_point::now();
+}
+
+uint32_t elasticsearch_exporter::last_acknowledged_block()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _acknowledged_block;
+}
+
+bool elasticsearch_exporter::is_idle()const
+{
+   std::lock_guard<std::mutex> lock( _mutex );
+   return _acknowledged == _written;
+}
+
+bool elasticsearch_exporter::read_batch( spool_position& pos, const spool_position& end,
+                                         std::string& body, uint32_t& last_block_num )
+{
+   uint64_t lines = 0;
+   while( pos != end && lines < 2 * uint64_t(_settings.max_batch_documents) )
+   {
+      if( !_reader || _reader_segment != pos.segment )
+      {
+         if( _reader )
+            std::fclose( _reader );
+         _reader_segment = pos.segment;
+         _reader = std::fopen( segment_path( pos.segment ).generic_string().c_str(), "rb" );
+         FC_ASSERT( _reader != nullptr, "Unable to open elasticsearch spool segment ${s}", ("s", pos.segment) );
+      }
+      std::fseek( _reader, pos.offset, SEEK_SET );
+
+      record_header header;
+      if( std::fread( &header, sizeof(header), 1, _reader ) != 1 )
+      {
+         // the writer only moves to the next segment after finishing this one
+         FC_ASSERT( pos.segment < end.segment, "Elasticsearch spool segment ${s} is shorter than expected", ("s", pos.segment) );
+         ++pos.segment;
+         pos.offset = 0;
+         continue;
+      }
+      const size_t body_size = body.size();
+      body.resize( body_size + header.size );
+      FC_ASSERT( std::fread( &body[body_size], header.size, 1, _reader ) == 1,
+                 "Elasticsearch spool segment ${s} is shorter than expected", ("s", pos.segment) );
+      pos.offset += sizeof(header) + header.size;
+      if( record_checksum( body.data() + body_size, header.size ) != header.checksum )
+      {
+         elog( "Skipping a corrupted record of block ${b} in the elasticsearch spool", ("b", header.block_num) );
+         body.resize( body_size );
+         continue;
+      }
+      lines += header.line_count;
+      last_block_num = header.block_num;
+   }
+   return !body.empty();
+}
+
+bool elasticsearch_exporter::post_bulk( void* curl, const std::string& body )
+{
+   CurlRequest curl_request;
+   curl_request.handler = (CURL*)curl;
+   curl_request.url = _settings.elasticsearch_url + "_bulk";
+   curl_request.auth = _settings.auth;
+   curl_request.type = "POST";
+   if( _settings.compress )
+   {
+      boost::iostreams::filtering_ostream out;
+      out.push( boost::iostreams::gzip_compressor() );
+      out.push( boost::iostreams::back_inserter( curl_request.query ) );
+      out.write( body.data(), body.size() );
+      out.reset();
+      curl_request.content_encoding = "gzip";
+   }
+   else
+      curl_request.query = body;
+
+   const std::string response = doCurl( curl_request );
+   const long http_code = getResponseCode( curl_request.handler );
+   if( http_code != 200 )
+   {
+      elog( "Elasticsearch bulk request failed with HTTP status ${code}, retrying", ("code", http_code) );
+      return false;
+   }
+   try
+   {
+      // documents the cluster rejected one by one would be rejected again, don't retry them
+      if( fc::json::from_string( response )["errors"].as_bool() )
+         elog( "Elasticsearch rejected some of the documents of a bulk request" );
+   }
+   catch( const fc::exception& e )
+   {
+      elog( "Unable to parse the elasticsearch bulk response: ${e}", ("e", e.to_detail_string()) );
+   }
+   return true;
+}
+
+void elasticsearch_exporter::send_loop()
+{
+   CURL* curl = curl_easy_init();
+   // don't let a hung connection keep the exporter from shutting down
+   curl_easy_setopt( curl, CURLOPT_TIMEOUT, 60L );
+   spool_position pos;
+   {
+      std::lock_guard<std::mutex> lock( _mutex );
+      pos = _acknowledged;
+   }
+   fc::microseconds retry_interval = _settings.retry_interval;
+
+   while( true )
+   {
+      spool_position end;
+      {
+         std::unique_lock<std::mutex> lock( _mutex );
+         _cv.wait( lock, [&]() { return _stopping || _written != pos; } );
+         if( _stopping )
+            break;
+         end = _written;
+      }
+
+      std::string body;
+      spool_position batch_end = pos;
+      uint32_t last_block_num = 0;
+      try
+      {
+         if( !read_batch( batch_end, end, body, last_block_num ) )
+         {
+            pos = batch_end;
+            continue;
+         }
+      }
+      catch( const fc::exception& e )
+      {
+         elog( "Unable to read the elasticsearch spool, stopping the exporter: ${e}", ("e", e.to_detail_string()) );
+         break;
+      }
+
+      if( !post_bulk( curl, body ) )
+      {
+         std::unique_lock<std::mutex> lock( _mutex );
+         if( _cv.wait_for( lock, std::chrono::microseconds( retry_interval.count() ), [this]() { return _stopping; } ) )
+            break;
+         retry_interval = std::min( retry_interval + retry_interval, fc::microseconds( fc::minutes(1) ) );
+         continue;
+      }
+      retry_interval = _settings.retry_interval;
+
+      save_acknowledged( batch_end, last_block_num );
+      for( uint64_t segment = pos.segment; segment < batch_end.segment; ++segment )
+         boost::filesystem::remove( segment_path( segment ).generic_string() );
+      pos = batch_end;
+      {
+         std::lock_guard<std::mutex> lock( _mutex );
+         _acknowledged = pos;
+         _acknowledged_block = last_block_num;
+      }
+   }
+
+   curl_easy_cleanup( curl );
+}
+
+} } // end namespace graphene::utilities
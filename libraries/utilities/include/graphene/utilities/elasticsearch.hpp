@@ -51,6 +51,7 @@ namespace graphene { namespace utilities {
          std::string type;
          std::string auth;
          std::string query;
+         std::string content_encoding;
    };
 
    bool SendBulk(ES& es);
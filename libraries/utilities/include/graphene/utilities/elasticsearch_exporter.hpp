@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2018 oxarbitrage, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#pragma once
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fc/filesystem.hpp>
+#include <fc/time.hpp>
+
+namespace graphene { namespace utilities {
+
+   /**
+    *  Sends Elasticsearch bulk lines from a background thread, through a spool on disk.
+    *
+    *  The lines of each block are appended to the spool as one record, and a sender thread posts
+    *  the spooled records to the _bulk endpoint in batches, retrying until the cluster accepts
+    *  them.  The position of the last accepted record is saved in the spool, so after a restart
+    *  the sender continues with the first record that wasn't accepted.  The caller only ever
+    *  waits for the spool to be written, never for the cluster.
+    *
+    *  The spool is a sequence of segment files holding records of
+    *  [block number, line count, size, crc32, lines].  A torn record at the end of the last
+    *  segment, left by a crash, is cut off when the spool is opened.
+    */
+   class elasticsearch_exporter
+   {
+      public:
+         struct settings
+         {
+            std::string      elasticsearch_url;
+            std::string      auth;
+            fc::path         spool_dir;
+            /** at most this many documents (two lines each) are sent in one request */
+            uint32_t         max_batch_documents = 10000;
+            /** a new segment is started once the current one grows past this size */
+            uint64_t         segment_size = 64 * 1024 * 1024;
+            /** the spool is synced to disk at most this often, and when the exporter is closed */
+            fc::microseconds sync_interval = fc::seconds(1);
+            /** the first retry after a failed request, doubled after each further failure */
+            fc::microseconds retry_interval = fc::seconds(1);
+            /** gzip the request bodies */
+            bool             compress = true;
+         };
+
+         explicit elasticsearch_exporter( const settings& s );
+         /** syncs the spool and stops the sender, records that weren't accepted yet are sent after a restart */
+         ~elasticsearch_exporter();
+
+         /** appends the bulk lines of a block to the spool, the sender picks them up from there */
+         void add_block( uint32_t block_num, const std::vector<std::string>& bulk_lines );
+         /** writes everything spooled so far to disk */
+         void sync();
+
+         /** @return the number of the last block whose documents were accepted by the cluster */
+         uint32_t last_acknowledged_block()const;
+         /** @return true if every spooled record was accepted by the cluster */
+         bool is_idle()const;
+
+      private:
+         struct spool_position
+         {
+            uint64_t segment = 0;
+            uint64_t offset = 0;
+
+            bool operator==( const spool_position& o )const { return segment == o.segment && offset == o.offset; }
+            bool operator!=( const spool_position& o )const { return !(*this == o); }
+         };
+         struct record_header
+         {
+            uint32_t block_num = 0;
+            uint32_t line_count = 0;
+            uint32_t size = 0;
+            uint32_t checksum = 0;
+         };
+
+         fc::path segment_path( uint64_t segment )const;
+         fc::path acknowledged_path()const;
+         void open_spool();
+         void open_segment( uint64_t segment );
+         void save_acknowledged( const spool_position& pos, uint32_t block_num );
+
+         void send_loop();
+         /** reads records from pos up to end into body, @return false if there was nothing to read */
+         bool read_batch( spool_position& pos, const spool_position& end, std::string& body, uint32_t& last_block_num );
+         /** @return true if the cluster accepted the request */
+         bool post_bulk( void* curl, const std::string& body );
+
+         const settings        _settings;
+
+         // owned by the thread calling add_block()
+         std::FILE*            _writer = nullptr;
+         spool_position        _write_position;
+         fc::time_point        _last_sync;
+
+         // owned by the sender thread
+         std::FILE*            _reader = nullptr;
+         uint64_t              _reader_segment = 0;
+
+         mutable std::mutex      _mutex;
+         std::condition_variable _cv;
+         /** the end of the records that were completely written */
+         spool_position        _written;
+         spool_position        _acknowledged;
+         uint32_t              _acknowledged_block = 0;
+         bool                  _stopping = false;
+
+         std::thread           _sender;
+   };
+
+} } // end namespace graphene::utilities
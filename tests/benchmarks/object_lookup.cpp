@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+#include <graphene/app/database_api.hpp>
+#include <graphene/chain/database.hpp>
+#include <graphene/chain/account_object.hpp>
+#include <graphene/chain/asset_object.hpp>
+#include <graphene/utilities/tempdir.hpp>
+#include <fc/crypto/digest.hpp>
+#include <boost/test/auto_unit_test.hpp>
+
+#include "../common/database_fixture.hpp"
+
+using namespace graphene::chain;
+
+namespace {
+
+genesis_state_type make_lookup_genesis( int account_count )
+{
+   genesis_state_type genesis_state;
+   genesis_state.initial_timestamp = time_point_sec( GRAPHENE_TESTING_GENESIS_TIMESTAMP );
+
+   auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")));
+   genesis_state.initial_active_witnesses = 10;
+   for( int i = 0; i < genesis_state.initial_active_witnesses; ++i )
+   {
+      auto name = "init"+fc::to_string(i);
+      genesis_state.initial_accounts.emplace_back(name,
+                                                  init_account_priv_key.get_public_key(),
+                                                  init_account_priv_key.get_public_key(),
+                                                  true);
+      genesis_state.initial_committee_candidates.push_back({name});
+      genesis_state.initial_witness_candidates.push_back({name, init_account_priv_key.get_public_key()});
+   }
+   for( int i = 0; i < account_count; ++i )
+      genesis_state.initial_accounts.emplace_back("target"+fc::to_string(i),
+                                                  public_key_type(fc::ecc::private_key::regenerate(fc::digest(i)).get_public_key()));
+   genesis_state.initial_parameters.current_fees->zero_all_fees();
+   return genesis_state;
+}
+
+/** @return the time in microseconds to look up the accounts, their statistics and the core asset rounds times */
+int64_t time_lookups( const database& db, const vector<account_id_type>& accounts, int rounds, share_type& checksum )
+{
+   auto start_time = fc::time_point::now();
+   for( int r = 0; r < rounds; ++r )
+      for( const auto& id : accounts )
+      {
+         const account_object& account = id(db);
+         checksum += account.statistics(db).total_ops;
+         checksum += asset_id_type()(db).dynamic_asset_data_id(db).current_supply;
+      }
+   return (fc::time_point::now() - start_time).count();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE( dense_lookup_bench )
+{
+   try {
+#ifdef NDEBUG
+      ilog("Running in release mode.");
+      const int account_count = 200000;
+      const int blocks_to_produce = 2000;
+      const int lookup_rounds = 20;
+#else
+      ilog("Running in debug mode.");
+      const int account_count = 5000;
+      const int blocks_to_produce = 100;
+      const int lookup_rounds = 2;
+#endif
+      const int transfers_per_block = 50;
+
+      const genesis_state_type genesis_state = make_lookup_genesis( account_count );
+      auto init_account_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("null_key")));
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      {
+         database db;
+         db.open(data_dir.path(), [&]{return genesis_state;}, "TEST");
+
+         const auto& accounts_by_name = db.get_index_type<account_index>().indices().get<by_name>();
+         vector<account_id_type> accounts;
+         for( const auto& account : accounts_by_name )
+            accounts.push_back( account.id );
+
+         // transfers from the committee account to the genesis accounts, replayed below
+         for( int i = 0; i < blocks_to_produce; ++i )
+         {
+            signed_transaction trx;
+            trx.set_expiration( db.head_block_time() + fc::minutes(1) );
+            for( int t = 0; t < transfers_per_block; ++t )
+            {
+               transfer_operation op;
+               op.from = GRAPHENE_COMMITTEE_ACCOUNT;
+               op.to = accounts[ (i * transfers_per_block + t) % accounts.size() ];
+               op.amount = asset(1);
+               trx.operations.push_back( op );
+            }
+            db.push_transaction( trx, ~0 );
+            db.generate_block( db.get_slot_time(1), db.get_scheduled_witness(1), init_account_priv_key, ~0 );
+         }
+
+         share_type tree_checksum;
+         share_type dense_checksum;
+         auto tree_time = time_lookups( db, accounts, lookup_rounds, tree_checksum );
+         db.enable_dense_lookup( true );
+         auto dense_time = time_lookups( db, accounts, lookup_rounds, dense_checksum );
+         BOOST_CHECK_EQUAL( tree_checksum.value, dense_checksum.value );
+         ilog( "Looked up ${n} accounts ${r} times in ${t} ms with the index trees and in ${d} ms with the dense tables.",
+               ("n",accounts.size())("r",lookup_rounds)("t",tree_time / 1000)("d",dense_time / 1000) );
+
+         graphene::app::database_api db_api( db );
+         vector<object_id_type> ids;
+         for( const auto& id : accounts )
+         {
+            ids.push_back( id );
+            ids.push_back( id(db).statistics );
+         }
+         db.enable_dense_lookup( false );
+         auto start_time = fc::time_point::now();
+         auto tree_objects = db_api.get_objects( ids );
+         tree_time = (fc::time_point::now() - start_time).count();
+         db.enable_dense_lookup( true );
+         start_time = fc::time_point::now();
+         auto dense_objects = db_api.get_objects( ids );
+         dense_time = (fc::time_point::now() - start_time).count();
+         BOOST_CHECK_EQUAL( tree_objects.size(), dense_objects.size() );
+         ilog( "get_objects for ${n} objects took ${t} ms with the index trees and ${d} ms with the dense tables.",
+               ("n",ids.size())("t",tree_time / 1000)("d",dense_time / 1000) );
+
+         db.close();
+      }
+
+      uint32_t replayed_blocks = 0;
+      for( bool dense : { false, true } )
+      {
+         database db;
+         db.enable_dense_lookup( dense );
+         auto start_time = fc::time_point::now();
+         // a changed db_version wipes the object database and replays the blocks
+         db.open(data_dir.path(), [&]{return genesis_state;}, dense ? "dense_replay" : "tree_replay");
+         ilog( "Replayed ${b} blocks in ${t} milliseconds with dense lookup ${d}.",
+               ("b",db.head_block_num())("t", (fc::time_point::now() - start_time).count() / 1000)("d",dense) );
+         if( dense )
+            BOOST_CHECK_EQUAL( db.head_block_num(), replayed_blocks );
+         replayed_blocks = db.head_block_num();
+         db.close();
+      }
+   } catch(fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
@@ -415,6 +415,134 @@ BOOST_AUTO_TEST_CASE(binned_order_books)
    } FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(binned_order_book_follows_changes)
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      CREATE_ICE_HOCKEY_BETTING_MARKET(false, 0);
+
+      graphene::bookie::bookie_api bookie_api(app);
+
+      transfer(account_id_type(), alice_id, asset(10000));
+      transfer(account_id_type(), bob_id, asset(10000));
+      generate_blocks(1);
+
+      // the sum of each side of the binned book must match the bets on the books
+      auto check_order_book = [&](share_type expected_back, share_type expected_lay) {
+         for (int32_t precision : { 0, 1, 2 })
+         {
+            graphene::bookie::binned_order_book binned_orders = bookie_api.get_binned_order_book(capitals_win_market.id, precision);
+            share_type back_total;
+            share_type lay_total;
+            for (const graphene::bookie::order_bin& binned_order : binned_orders.aggregated_back_bets)
+               back_total += binned_order.amount_to_bet;
+            for (const graphene::bookie::order_bin& binned_order : binned_orders.aggregated_lay_bets)
+               lay_total += binned_order.amount_to_bet;
+            BOOST_CHECK_EQUAL(back_total.value, expected_back.value);
+            BOOST_CHECK_EQUAL(lay_total.value, expected_lay.value);
+         }
+      };
+
+      place_bet(bob_id, capitals_win_market.id, bet_type::back, asset(100, asset_id_type()), 155 * GRAPHENE_BETTING_ODDS_PRECISION / 100);
+      place_bet(bob_id, capitals_win_market.id, bet_type::back, asset(200, asset_id_type()), 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+      check_order_book(300, 0);
+
+      graphene::bookie::binned_order_book binned_orders_point_one = bookie_api.get_binned_order_book(capitals_win_market.id, 1);
+      BOOST_REQUIRE_EQUAL(binned_orders_point_one.aggregated_back_bets.size(), 2u);
+      BOOST_CHECK_EQUAL(binned_orders_point_one.aggregated_back_bets[0].backer_multiplier, 16 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+      BOOST_CHECK_EQUAL(binned_orders_point_one.aggregated_back_bets[1].backer_multiplier, 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+      generate_blocks(1);
+
+      // alice's lay consumes the bet at 2.0 completely
+      place_bet(alice_id, capitals_win_market.id, bet_type::lay, asset(200, asset_id_type()), 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+      place_bet(alice_id, capitals_win_market.id, bet_type::lay, asset(50, asset_id_type()), 15 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+      check_order_book(100, 50);
+      generate_blocks(1);
+      check_order_book(100, 50);
+
+      // undoing the block puts the order book back the way it was
+      db.pop_block();
+      check_order_book(300, 0);
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_CASE(binned_order_book_subscription)
+{
+   try
+   {
+      ACTORS( (alice)(bob) );
+      CREATE_ICE_HOCKEY_BETTING_MARKET(false, 0);
+
+      graphene::bookie::bookie_api bookie_api(app);
+
+      transfer(account_id_type(), alice_id, asset(10000));
+      transfer(account_id_type(), bob_id, asset(10000));
+      generate_blocks(1);
+
+      std::vector<graphene::bookie::binned_order_book> notifications;
+      bookie_api.subscribe_to_binned_order_book([&](const variant& v) {
+         auto item = v.as<std::pair<betting_market_id_type, graphene::bookie::binned_order_book>>(GRAPHENE_MAX_NESTED_OBJECTS);
+         BOOST_CHECK(item.first == capitals_win_market.id);
+         notifications.push_back(item.second);
+      }, capitals_win_market.id, 1);
+      // the notifications are sent asynchronously after the block
+      auto generate_block_and_notify = [&]() {
+         generate_blocks(1);
+         fc::usleep(fc::milliseconds(10));
+      };
+
+      // a new bet is pushed once its block is applied
+      place_bet(bob_id, capitals_win_market.id, bet_type::back, asset(100, asset_id_type()), 155 * GRAPHENE_BETTING_ODDS_PRECISION / 100);
+      BOOST_CHECK_EQUAL(notifications.size(), 0u);
+      generate_block_and_notify();
+      BOOST_REQUIRE_EQUAL(notifications.size(), 1u);
+      BOOST_REQUIRE_EQUAL(notifications[0].aggregated_back_bets.size(), 1u);
+      BOOST_CHECK_EQUAL(notifications[0].aggregated_back_bets[0].amount_to_bet.value, 100);
+      BOOST_CHECK_EQUAL(notifications[0].aggregated_back_bets[0].backer_multiplier, 16 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+
+      // blocks that leave the book as it was are not pushed
+      generate_block_and_notify();
+      BOOST_CHECK_EQUAL(notifications.size(), 1u);
+
+      bet_id_type placed_and_canceled = place_bet(alice_id, capitals_win_market.id, bet_type::lay, asset(50, asset_id_type()), 15 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+      bet_cancel_operation bet_cancel_op;
+      bet_cancel_op.bettor_id = alice_id;
+      bet_cancel_op.bet_to_cancel = placed_and_canceled;
+      trx.operations.push_back(bet_cancel_op);
+      trx.validate();
+      db.push_transaction(trx, ~0);
+      trx.operations.clear();
+      generate_block_and_notify();
+      BOOST_CHECK_EQUAL(notifications.size(), 1u);
+
+      // more stake in a bin that is already there is pushed
+      place_bet(bob_id, capitals_win_market.id, bet_type::back, asset(20, asset_id_type()), 158 * GRAPHENE_BETTING_ODDS_PRECISION / 100);
+      generate_block_and_notify();
+      BOOST_REQUIRE_EQUAL(notifications.size(), 2u);
+      BOOST_CHECK_EQUAL(notifications[1].aggregated_back_bets[0].amount_to_bet.value, 120);
+
+      // a canceled bet is pushed as well
+      bet_cancel_op.bettor_id = bob_id;
+      bet_cancel_op.bet_to_cancel = place_bet(bob_id, capitals_win_market.id, bet_type::back, asset(30, asset_id_type()), 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+      generate_block_and_notify();
+      BOOST_REQUIRE_EQUAL(notifications.size(), 3u);
+      BOOST_CHECK_EQUAL(notifications[2].aggregated_back_bets.size(), 2u);
+      trx.operations.push_back(bet_cancel_op);
+      trx.validate();
+      db.push_transaction(trx, ~0);
+      trx.operations.clear();
+      generate_block_and_notify();
+      BOOST_REQUIRE_EQUAL(notifications.size(), 4u);
+      BOOST_CHECK_EQUAL(notifications[3].aggregated_back_bets.size(), 1u);
+
+      bookie_api.unsubscribe_from_binned_order_book(capitals_win_market.id);
+      place_bet(bob_id, capitals_win_market.id, bet_type::back, asset(30, asset_id_type()), 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+      generate_block_and_notify();
+      BOOST_CHECK_EQUAL(notifications.size(), 4u);
+   } FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE( peerplays_sport_create_test )
 {
    try
@@ -1444,6 +1572,95 @@ BOOST_AUTO_TEST_CASE( cancel )
 
 BOOST_AUTO_TEST_SUITE_END()
 
+/**
+ *  Builds a book and sweeps it with taker bets, matching them either against the whole book in one pass or
+ *  against one maker bet at a time, and records everything that came out of it
+ */
+struct bet_matching_outcome_fixture : database_fixture
+{
+   std::string balances;
+   std::string positions;
+   std::string bets;
+   std::string virtual_ops;
+   bool has_canceled_bet = false;
+
+   explicit bet_matching_outcome_fixture(bool batched)
+   {
+      db.node_properties().batched_bet_matching = batched;
+      ACTORS( (alice)(bob)(carol)(dan) );
+      CREATE_ICE_HOCKEY_BETTING_MARKET(false, 0);
+      const vector<account_id_type> bettors = { alice_id, bob_id, carol_id, dan_id };
+      for (const auto& bettor : bettors)
+         transfer(account_id_type(), bettor, asset(10000000));
+
+      place_bet(alice_id, capitals_win_market.id, bet_type::lay, asset(47, asset_id_type()), 194 * GRAPHENE_BETTING_ODDS_PRECISION / 100);
+      place_bet(alice_id, capitals_win_market.id, bet_type::lay, asset(91, asset_id_type()), 191 * GRAPHENE_BETTING_ODDS_PRECISION / 100);
+      place_bet(bob_id, capitals_win_market.id, bet_type::lay, asset(999, asset_id_type()), 16 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+      place_bet(carol_id, capitals_win_market.id, bet_type::back, asset(300, asset_id_type()), 3 * GRAPHENE_BETTING_ODDS_PRECISION);
+      generate_blocks(1);
+
+      vector<operation> ops;
+      auto recorder = db.applied_block.connect([&](const signed_block&) {
+         for (const auto& op : db.get_applied_operations())
+            if (op.valid())
+               ops.push_back(op->op);
+      });
+      // dan sweeps both of alice's bets, matches part of bob's, and the rest of dan's bet is canceled
+      place_bet(dan_id, capitals_win_market.id, bet_type::back, asset(1002, asset_id_type()), 15 * GRAPHENE_BETTING_ODDS_PRECISION / 10);
+      // dan lays into carol's bet and stays on the books
+      place_bet(dan_id, capitals_win_market.id, bet_type::lay, asset(2000, asset_id_type()), 3 * GRAPHENE_BETTING_ODDS_PRECISION);
+      // bob backs against a book that still holds his own lay, which is matched one bet at a time either way
+      place_bet(bob_id, capitals_win_market.id, bet_type::back, asset(500, asset_id_type()), 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+      generate_blocks(1);
+      recorder.disconnect();
+
+      vector<int64_t> bettor_balances;
+      for (const auto& bettor : bettors)
+         bettor_balances.push_back(get_balance(bettor, asset_id_type()));
+      vector<betting_market_position_object> bettor_positions;
+      for (const auto& position : db.get_index_type<betting_market_position_index>().indices())
+         bettor_positions.push_back(position);
+      vector<bet_object> open_bets;
+      for (const auto& bet : db.get_index_type<bet_object_index>().indices())
+         open_bets.push_back(bet);
+
+      balances = fc::json::to_string(bettor_balances);
+      positions = fc::json::to_string(bettor_positions);
+      bets = fc::json::to_string(open_bets);
+      virtual_ops = fc::json::to_string(ops);
+      has_canceled_bet = std::any_of(ops.begin(), ops.end(), [](const operation& op) {
+         return op.which() == operation::tag<bet_canceled_operation>::value;
+      });
+   }
+};
+
+BOOST_AUTO_TEST_SUITE( bet_matching_tests )
+
+BOOST_AUTO_TEST_CASE( batched_matching_matches_sequential_matching )
+{
+   try
+   {
+      std::string balances, positions, bets, virtual_ops;
+      {
+         bet_matching_outcome_fixture sequential(false);
+         balances = sequential.balances;
+         positions = sequential.positions;
+         bets = sequential.bets;
+         virtual_ops = sequential.virtual_ops;
+      }
+      bet_matching_outcome_fixture batched(true);
+
+      BOOST_CHECK(batched.has_canceled_bet);
+      BOOST_CHECK_EQUAL(batched.balances, balances);
+      BOOST_CHECK_EQUAL(batched.positions, positions);
+      BOOST_CHECK_EQUAL(batched.bets, bets);
+      BOOST_CHECK_EQUAL(batched.virtual_ops, virtual_ops);
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
 struct simple_bet_test_fixture_2 : database_fixture {
    betting_market_id_type capitals_win_betting_market_id;
    simple_bet_test_fixture_2()
@@ -2084,6 +2301,69 @@ BOOST_AUTO_TEST_CASE(event_driven_standard_progression_1)
    } FC_LOG_AND_RETHROW()
 }
 
+// Searches event names through the bookie plugin while events are created, renamed, and settled
+BOOST_AUTO_TEST_CASE(event_name_search)
+{
+   try
+   {
+      CREATE_ICE_HOCKEY_BETTING_MARKET(false, 0);
+      graphene::bookie::bookie_api bookie_api(app);
+      // save the event id for checking after it is deleted
+      event_id_type capitals_vs_blackhawks_id = capitals_vs_blackhawks.id;
+
+      auto find_events = [&](const std::string& sub_string, const std::string& language) {
+         std::vector<event_id_type> event_ids;
+         for (const event_object& event : bookie_api.get_events_containing_sub_string(sub_string, language))
+            event_ids.push_back(event.id);
+         return event_ids;
+      };
+      const std::vector<event_id_type> capitals_only = {capitals_vs_blackhawks_id};
+
+      BOOST_TEST_MESSAGE("searching the new event");
+      BOOST_CHECK(find_events("Capitals/Chicago", "en") == capitals_only);
+      BOOST_CHECK(find_events("blackHAWKS", "en") == capitals_only);
+      BOOST_CHECK(find_events("キャピタルズ", "ja") == capitals_only);
+      BOOST_CHECK(find_events("Ch", "en") == capitals_only);
+      BOOST_CHECK(find_events("/", "en") == capitals_only);
+      BOOST_CHECK(find_events("Capitals", "ja").empty());
+      BOOST_CHECK(find_events("Capitals", "fr").empty());
+      BOOST_CHECK(find_events("Rangers", "en").empty());
+      BOOST_CHECK(find_events("Xy", "en").empty());
+
+      BOOST_TEST_MESSAGE("renaming the event");
+      update_event(capitals_vs_blackhawks.id, _name = internationalized_string_type({{"en", "Washington Capitals/New York Rangers"}}));
+      generate_blocks(1);
+      BOOST_CHECK(find_events("Chicago", "en").empty());
+      BOOST_CHECK(find_events("Ch", "en").empty());
+      BOOST_CHECK(find_events("NEW YORK", "en") == capitals_only);
+      BOOST_CHECK(find_events("capitals", "en") == capitals_only);
+
+      BOOST_TEST_MESSAGE("creating a second event");
+      create_event({{"en", "Chicago Blackhawks/Boston Bruins"}}, {{"en", "2016-17"}}, nhl.id);
+      generate_blocks(1);
+      event_id_type blackhawks_vs_bruins_id = db.get_index_type<event_object_index>().indices().get<by_id>().rbegin()->id;
+      BOOST_CHECK(find_events("chicago", "en") == std::vector<event_id_type>({blackhawks_vs_bruins_id}));
+      BOOST_CHECK(find_events("CA", "en") == std::vector<event_id_type>({capitals_vs_blackhawks_id, blackhawks_vs_bruins_id}));
+      BOOST_CHECK(find_events("s/", "en") == std::vector<event_id_type>({capitals_vs_blackhawks_id, blackhawks_vs_bruins_id}));
+
+      BOOST_TEST_MESSAGE("settling the first event");
+      update_event(capitals_vs_blackhawks.id, _status = event_status::finished);
+      generate_blocks(1);
+      resolve_betting_market_group(moneyline_betting_markets.id,
+                                   {{capitals_win_market.id, betting_market_resolution_type::win},
+                                    {blackhawks_win_market.id, betting_market_resolution_type::not_win}});
+      generate_blocks(2);
+      BOOST_REQUIRE(!db.find(capitals_vs_blackhawks_id));
+
+      // the settled event is still found, from its persistent copy
+      std::vector<event_object> events = bookie_api.get_events_containing_sub_string("Rangers", "en");
+      BOOST_REQUIRE_EQUAL(events.size(), 1u);
+      BOOST_CHECK(events[0].id == capitals_vs_blackhawks_id);
+      BOOST_CHECK(events[0].get_status() == event_status::settled);
+      BOOST_CHECK(find_events("CA", "en") == std::vector<event_id_type>({capitals_vs_blackhawks_id, blackhawks_vs_bruins_id}));
+   } FC_LOG_AND_RETHROW()
+}
+
 // This tests a normal progression by setting the event state and
 // letting it trickle down.  Like the above, with delayed settling:
 // - upcoming
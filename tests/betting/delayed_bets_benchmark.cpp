@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "../common/betting_test_markets.hpp"
+
+using namespace graphene::chain;
+
+BOOST_FIXTURE_TEST_SUITE( delayed_bets_benchmark, database_fixture )
+
+/**
+ *  Freezes a market while it has delayed bets and times the blocks produced afterwards, for a growing
+ *  number of delayed bets.  The time per block should not depend on the number of bets waiting, which
+ *  is checked by counting what place_delayed_bets() examines rather than by comparing the timings.
+ */
+BOOST_AUTO_TEST_CASE( delayed_bets_on_frozen_market_benchmark )
+{
+   try
+   {
+      ACTORS( (alice) );
+      transfer(account_id_type(), alice_id, asset(100000000));
+      generate_blocks(1);
+
+#ifdef NDEBUG
+      const vector<uint32_t> bet_counts = { 50, 500, 5000 };
+      const uint32_t blocks_to_time = 100;
+#else
+      const vector<uint32_t> bet_counts = { 10, 100, 1000 };
+      const uint32_t blocks_to_time = 20;
+#endif
+      const auto& bet_odds_idx = db.get_index_type<bet_object_index>().indices().get<by_odds>();
+      const auto& delayed_bets = db.get_index_type< primary_index<bet_object_index> >().get_secondary_index<delayed_bet_index>();
+      size_t frozen_bets = 0;
+      size_t frozen_markets = 0;
+      for( uint32_t bet_count : bet_counts )
+      {
+         CREATE_ICE_HOCKEY_BETTING_MARKET(false, 0);
+         update_betting_market_group(moneyline_betting_markets.id, _status = betting_market_group_status::in_play);
+         generate_blocks(1);
+
+         // the bets and the freeze go into the same block, so no delay ends in between
+         for( uint32_t i = 0; i < bet_count; ++i )
+            place_bet(alice_id, capitals_win_market.id, bet_type::back, asset(100 + i, asset_id_type()), 2 * GRAPHENE_BETTING_ODDS_PRECISION);
+         update_betting_market_group(moneyline_betting_markets.id, _status = betting_market_group_status::frozen);
+         generate_blocks(1);
+         frozen_bets += bet_count;
+         ++frozen_markets;
+
+         // let the delays end
+         generate_blocks(5);
+
+         auto start_time = fc::time_point::now();
+         generate_blocks(blocks_to_time);
+         auto elapsed = fc::time_point::now() - start_time;
+
+         // none of the bets was placed in the book of the frozen markets
+         size_t delayed = 0;
+         for( const auto& bet : bet_odds_idx )
+            if( bet.end_of_delay )
+               ++delayed;
+         BOOST_CHECK_EQUAL( frozen_bets, delayed );
+
+         // each block looks at every frozen market once, and at none of the bets waiting on them
+         size_t markets_examined = 0;
+         vector<bet_id_type> bets_due = delayed_bets.get_bets_due( db.head_block_time(), [&]( betting_market_id_type market_id ) {
+            ++markets_examined;
+            return market_id(db).get_status() != betting_market_status::unresolved;
+         });
+         BOOST_CHECK( bets_due.empty() );
+         BOOST_CHECK_EQUAL( frozen_markets, markets_examined );
+
+         ilog( "${b} blocks with ${n} delayed bets on frozen markets took ${t} us per block",
+               ("b",blocks_to_time)("n",frozen_bets)("t",elapsed.count() / blocks_to_time) );
+      }
+   }
+   FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2018 Peerplays Blockchain Standards Association, and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <random>
+
+#include "../common/betting_test_markets.hpp"
+
+using namespace graphene::chain;
+
+BOOST_FIXTURE_TEST_SUITE( bet_matching_benchmark, database_fixture )
+
+/**
+ *  Replays the same synthetic order flow every run: a few bettors placing back and lay bets around
+ *  evens on one market, many of them crossing several bets on the other side of the book.
+ *
+ *  Backs and lays come from different bettors, so a taker never finds its own bet on the other side of
+ *  the book, which would make place_bet() match one bet at a time.
+ */
+BOOST_AUTO_TEST_CASE( synthetic_order_flow_benchmark )
+{
+   try
+   {
+      ACTORS( (alice)(bob)(carol)(dan) );
+      const vector<account_id_type> backers = { alice_id, bob_id };
+      const vector<account_id_type> layers = { carol_id, dan_id };
+      for( const auto& bettor : { alice_id, bob_id, carol_id, dan_id } )
+         transfer(account_id_type(), bettor, asset(1000000000));
+      generate_blocks(1);
+
+      CREATE_ICE_HOCKEY_BETTING_MARKET(false, 0);
+      generate_blocks(1);
+
+#ifdef NDEBUG
+      const uint32_t bet_count = 20000;
+#else
+      const uint32_t bet_count = 2000;
+#endif
+      const uint32_t bets_per_block = 100;
+      const vector<bet_multiplier_type> odds = { 15000, 16000, 17500, 18000, 19000, 20000, 21000, 22000, 25000 };
+
+      // every fill is reported by one bet_matched_operation for the taker and one for the maker
+      uint64_t matched_ops = 0;
+      auto counter = db.applied_block.connect( [&]( const signed_block& ) {
+         for( const auto& op : db.get_applied_operations() )
+            if( op.valid() && op->op.which() == operation::tag<bet_matched_operation>::value )
+               ++matched_ops;
+      });
+
+      std::mt19937 order_flow( 1000 );
+      std::uniform_int_distribution<size_t> pick_bettor( 0, 1 );
+      std::uniform_int_distribution<size_t> pick_odds( 0, odds.size() - 1 );
+      std::uniform_int_distribution<int64_t> pick_amount( 1, 200 );
+
+      auto start_time = fc::time_point::now();
+      for( uint32_t i = 0; i < bet_count; ++i )
+      {
+         bet_type back_or_lay = order_flow() % 2 ? bet_type::back : bet_type::lay;
+         account_id_type bettor = ( back_or_lay == bet_type::back ? backers : layers )[pick_bettor( order_flow )];
+         bet_multiplier_type multiplier = odds[pick_odds( order_flow )];
+         // every fifth bet is large enough to sweep through several bets on the other side of the book;
+         // adding i keeps the transactions distinct
+         int64_t amount = pick_amount( order_flow ) * ( i % 5 ? 100 : 2000 ) + i;
+         place_bet(bettor, capitals_win_market.id, back_or_lay, asset(amount, asset_id_type()), multiplier);
+         if( i % bets_per_block == bets_per_block - 1 )
+            generate_blocks(1);
+      }
+      generate_blocks(1);
+      auto elapsed = fc::time_point::now() - start_time;
+      counter.disconnect();
+
+      const uint64_t fills = matched_ops / 2;
+      BOOST_CHECK( fills > 0 );
+      ilog( "Placed ${n} bets with ${m} fills in ${t} ms, ${r} fills per second",
+            ("n", bet_count)("m", fills)("t", elapsed.count() / 1000)
+            ("r", fills * 1000000 / std::max<int64_t>(elapsed.count(), 1)) );
+   } FC_LOG_AND_RETHROW()
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -127,6 +127,10 @@ database_fixture::database_fixture()
       options.insert(std::make_pair("track-account", boost::program_options::variable_value(track_account, false)));
    }
 
+   // per operation type history index
+   if( boost::unit_test::framework::current_test_case().p_name.value == "get_account_history_by_operations" )
+      options.insert(std::make_pair("index-operation-types", boost::program_options::variable_value(true, false)));
+
    // standby votes tracking
    if( boost::unit_test::framework::current_test_case().p_name.value == "track_votes_witnesses_disabled" ||
        boost::unit_test::framework::current_test_case().p_name.value == "track_votes_committee_disabled") {
@@ -149,6 +153,9 @@ database_fixture::database_fixture()
       options.insert(std::make_pair("elasticsearch-operation-object", boost::program_options::variable_value(true, false)));
       options.insert(std::make_pair("elasticsearch-operation-string", boost::program_options::variable_value(true, false)));
       options.insert(std::make_pair("elasticsearch-mode", boost::program_options::variable_value(uint16_t(2), false)));
+      es_spool_dir = fc::temp_directory( graphene::utilities::temp_directory_path() );
+      options.insert(std::make_pair("elasticsearch-spool-dir", boost::program_options::variable_value(
+            boost::filesystem::path(es_spool_dir->path().generic_string()), false)));
 
       esplugin->plugin_initialize(options);
       esplugin->plugin_startup();
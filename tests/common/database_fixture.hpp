@@ -158,6 +158,8 @@ namespace graphene { namespace chain {
    }
 
 struct database_fixture {
+   // declared before app so that it outlives the elasticsearch plugin
+   optional<fc::temp_directory> es_spool_dir;
    // the reason we use an app is to exercise the indexes of built-in
    //   plugins
    graphene::app::application app;
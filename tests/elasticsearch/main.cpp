@@ -27,8 +27,13 @@
 #include <fc/crypto/digest.hpp>
 
 #include <graphene/utilities/elasticsearch.hpp>
+#include <graphene/utilities/elasticsearch_exporter.hpp>
 #include <graphene/elasticsearch/elasticsearch_plugin.hpp>
 
+#include <fc/network/http/server.hpp>
+
+#include <fstream>
+
 #include "../common/database_fixture.hpp"
 
 #define BOOST_TEST_MODULE Elastic Search Database Tests
@@ -533,3 +538,107 @@ BOOST_AUTO_TEST_CASE(elasticsearch_history_api) {
    }
 }
 BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE( elasticsearch_exporter_tests )
+
+namespace {
+
+   /// a stand-in for the _bulk endpoint, failing the first fail_requests requests
+   struct bulk_stub
+   {
+      fc::http::server server;
+      std::string      received;
+      uint32_t         fail_requests = 0;
+
+      explicit bulk_stub( const std::string& endpoint )
+      {
+         server.listen( fc::ip::endpoint::from_string( endpoint ) );
+         server.on_request( [this]( const fc::http::request& req, const fc::http::server::response& resp ) {
+            if( fail_requests > 0 )
+            {
+               --fail_requests;
+               resp.set_status( fc::http::reply::InternalServerError );
+               resp.set_length( 0 );
+               return;
+            }
+            received.append( req.body.begin(), req.body.end() );
+            const std::string reply = "{\"errors\":false}";
+            resp.set_status( fc::http::reply::OK );
+            resp.set_length( reply.size() );
+            resp.write( reply.c_str(), reply.size() );
+         });
+      }
+   };
+
+   bool wait_for_block( const graphene::utilities::elasticsearch_exporter& exporter, uint32_t block_num )
+   {
+      // the stub answers on this thread, so wait without blocking it
+      for( int i = 0; i < 500 && exporter.last_acknowledged_block() < block_num; ++i )
+         fc::usleep( fc::milliseconds(10) );
+      return exporter.last_acknowledged_block() >= block_num;
+   }
+
+}
+
+BOOST_AUTO_TEST_CASE( exporter_spools_retries_and_resumes )
+{
+   try {
+      fc::temp_directory spool_dir( graphene::utilities::temp_directory_path() );
+      bulk_stub stub( "127.0.0.1:19201" );
+
+      graphene::utilities::elasticsearch_exporter::settings settings;
+      settings.elasticsearch_url = "http://127.0.0.1:19201/";
+      settings.spool_dir = spool_dir.path();
+      settings.retry_interval = fc::milliseconds(50);
+      settings.compress = false;
+
+      {
+         // the first request fails and is retried
+         stub.fail_requests = 1;
+         graphene::utilities::elasticsearch_exporter exporter( settings );
+         exporter.add_block( 1, { "h1", "d1" } );
+         exporter.add_block( 2, { "h2", "d2" } );
+         BOOST_REQUIRE( wait_for_block( exporter, 2 ) );
+         BOOST_CHECK( exporter.is_idle() );
+         BOOST_CHECK_EQUAL( stub.received, "h1\nd1\nh2\nd2\n" );
+      }
+
+      // a torn record left by a crash is dropped, the accepted blocks are not sent again
+      {
+         std::ofstream segment( (spool_dir.path() / "segment-0").generic_string(), std::ios::binary | std::ios::app );
+         segment.write( "torn", 4 );
+      }
+      {
+         graphene::utilities::elasticsearch_exporter exporter( settings );
+         BOOST_CHECK_EQUAL( exporter.last_acknowledged_block(), 2u );
+         exporter.add_block( 3, { "h3", "d3" } );
+         BOOST_REQUIRE( wait_for_block( exporter, 3 ) );
+         BOOST_CHECK_EQUAL( stub.received, "h1\nd1\nh2\nd2\nh3\nd3\n" );
+      }
+
+      // blocks that weren't accepted before a restart are sent after it
+      {
+         // wait for the first failure, the exporter then waits out the retry interval and can be stopped
+         auto failing_settings = settings;
+         failing_settings.retry_interval = fc::seconds(10);
+         stub.fail_requests = 1;
+         graphene::utilities::elasticsearch_exporter exporter( failing_settings );
+         exporter.add_block( 4, { "h4", "d4" } );
+         for( int i = 0; i < 500 && stub.fail_requests > 0; ++i )
+            fc::usleep( fc::milliseconds(10) );
+         BOOST_CHECK_EQUAL( stub.fail_requests, 0u );
+         BOOST_CHECK_EQUAL( exporter.last_acknowledged_block(), 3u );
+      }
+      {
+         graphene::utilities::elasticsearch_exporter exporter( settings );
+         BOOST_REQUIRE( wait_for_block( exporter, 4 ) );
+         BOOST_CHECK_EQUAL( stub.received, "h1\nd1\nh2\nd2\nh3\nd3\nh4\nd4\n" );
+      }
+   }
+   catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
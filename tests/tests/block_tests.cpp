@@ -35,6 +35,7 @@
 #include <graphene/chain/witness_schedule_object.hpp>
 #include <graphene/chain/witness_object.hpp>
 
+#include <graphene/net/core_messages.hpp>
 #include <graphene/utilities/tempdir.hpp>
 
 #include <fc/crypto/digest.hpp>
@@ -127,6 +128,190 @@ BOOST_AUTO_TEST_CASE( block_database_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( block_database_batched_writes )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      // enough blocks to spill the pending buffer to disk several times
+      signed_block b;
+      vector<block_id_type> ids;
+      while( ids.size() * fc::raw::pack_size( b ) < 3 * block_database::MAX_PENDING_BYTES )
+      {
+         if( !ids.empty() ) b.previous = b.id();
+         b.witness = witness_id_type( ids.size() + 1 );
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+      }
+
+      // read back from both the mapped files and the pending buffer
+      for( uint32_t i = 0; i < ids.size(); ++i )
+      {
+         FC_ASSERT( bdb.contains( ids[i] ) );
+         FC_ASSERT( bdb.fetch_block_id( i+1 ) == ids[i] );
+         auto blk = bdb.fetch_optional( ids[i] );
+         FC_ASSERT( blk.valid() );
+         FC_ASSERT( blk->witness == witness_id_type( i+1 ) );
+      }
+      FC_ASSERT( !bdb.fetch_by_number( ids.size() + 1 ).valid() );
+
+      bdb.remove( ids.back() );
+      FC_ASSERT( !bdb.contains( ids.back() ) );
+      FC_ASSERT( *bdb.last_id() == ids[ids.size() - 2] );
+
+      bdb.close();
+      bdb.open( data_dir.path() );
+      FC_ASSERT( *bdb.last_id() == ids[ids.size() - 2] );
+      for( uint32_t i = 0; i + 1 < ids.size(); ++i )
+      {
+         auto blk = bdb.fetch_by_number( i+1 );
+         FC_ASSERT( blk.valid() );
+         FC_ASSERT( blk->id() == ids[i] );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_serialized_blocks )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      signed_block b;
+      vector<block_id_type> ids;
+      for( uint32_t i = 0; i < 5; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+         if( i == 2 )
+            bdb.flush();
+      }
+
+      for( const auto& id : ids )
+      {
+         auto serialized = bdb.fetch_serialized( id );
+         FC_ASSERT( serialized.valid() );
+         const graphene::net::message expected( graphene::net::block_message( *bdb.fetch_optional( id ) ) );
+         const graphene::net::message msg = graphene::net::block_message::from_serialized_block( std::move( *serialized ), id );
+         BOOST_CHECK_EQUAL( expected.msg_type, msg.msg_type );
+         BOOST_CHECK_EQUAL( expected.size, msg.size );
+         BOOST_CHECK( expected.data == msg.data );
+         BOOST_CHECK( msg.as<graphene::net::block_message>().block_id == id );
+      }
+
+      // the id must match, not only the block number
+      FC_ASSERT( !bdb.fetch_serialized( block_id_type() ).valid() );
+      block_id_type wrong_id = ids[1];
+      wrong_id._hash[4] ^= 1;
+      FC_ASSERT( !bdb.fetch_serialized( wrong_id ).valid() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_range_reads )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+
+      signed_block b;
+      vector<block_id_type> ids;
+      for( uint32_t i = 0; i < 10; ++i )
+      {
+         if( i > 0 ) b.previous = b.id();
+         b.witness = witness_id_type(i+1);
+         bdb.store( b.id(), b );
+         ids.push_back( b.id() );
+         if( i == 5 )
+            bdb.flush();
+      }
+
+      // spans the flushed blocks, the pending ones and numbers past the end
+      auto blocks = bdb.fetch_range( 3, 10 );
+      auto serialized = bdb.fetch_serialized_range( 3, 10 );
+      BOOST_REQUIRE_EQUAL( blocks.size(), 10u );
+      BOOST_REQUIRE_EQUAL( serialized.size(), 10u );
+      for( uint32_t i = 0; i < 10; ++i )
+      {
+         const uint32_t block_num = 3 + i;
+         if( block_num > ids.size() )
+         {
+            BOOST_CHECK( !blocks[i].valid() );
+            BOOST_CHECK( !serialized[i].valid() );
+            continue;
+         }
+         BOOST_REQUIRE( blocks[i].valid() );
+         BOOST_CHECK( blocks[i]->id() == ids[block_num - 1] );
+         BOOST_REQUIRE( serialized[i].valid() );
+         BOOST_CHECK( *serialized[i] == fc::raw::pack( *blocks[i] ) );
+      }
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( block_database_flush_irreversible )
+{
+   try {
+      fc::temp_directory data_dir( graphene::utilities::temp_directory_path() );
+
+      block_database bdb;
+      bdb.open( data_dir.path() );
+      const fc::path index_filename = data_dir.path() / "index";
+
+      signed_block b;
+      vector<block_id_type> ids;
+      auto store_blocks = [&]( uint32_t count ) {
+         for( uint32_t i = 0; i < count; ++i )
+         {
+            if( !ids.empty() ) b.previous = b.id();
+            b.witness = witness_id_type( ids.size() + 1 );
+            bdb.store( b.id(), b );
+            ids.push_back( b.id() );
+         }
+      };
+
+      // a few irreversible blocks stay in memory
+      store_blocks( 10 );
+      bdb.flush_irreversible( 5 );
+      BOOST_CHECK_EQUAL( fc::file_size( index_filename ), 0u );
+      BOOST_CHECK( *bdb.last_id() == ids.back() );
+
+      // the batch is written once it holds enough of them
+      store_blocks( block_database::MAX_PENDING_IRREVERSIBLE_BLOCKS );
+      bdb.flush_irreversible( block_database::MAX_PENDING_IRREVERSIBLE_BLOCKS );
+      BOOST_CHECK_EQUAL( fc::file_size( index_filename ), 0u );
+      bdb.flush_irreversible( block_database::MAX_PENDING_IRREVERSIBLE_BLOCKS + 1 );
+      BOOST_CHECK_EQUAL( fc::file_size( index_filename ), ids.size() * sizeof(index_entry) );
+      BOOST_CHECK( *bdb.last_id() == ids.back() );
+
+      // pending blocks and removals take precedence over the ones on disk
+      bdb.remove( ids.back() );
+      BOOST_CHECK( *bdb.last_id() == ids[ids.size() - 2] );
+      store_blocks( 1 );
+      BOOST_CHECK( *bdb.last_id() == ids.back() );
+      BOOST_CHECK( bdb.fetch_by_number( ids.size() )->id() == ids.back() );
+   } catch (fc::exception& e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( generate_empty_blocks )
 {
    try {
@@ -866,6 +1051,38 @@ BOOST_FIXTURE_TEST_CASE( double_sign_check, database_fixture )
 
 } FC_LOG_AND_RETHROW() }
 
+BOOST_FIXTURE_TEST_CASE( precompute_parallel_signees, database_fixture )
+{ try {
+   signed_block blk;
+   vector<public_key_type> keys;
+   for( uint32_t i = 0; i < 16; ++i )
+   {
+      signed_transaction tx;
+      set_expiration( db, tx );
+      transfer_operation t;
+      t.amount = asset( i + 1 );
+      tx.operations.push_back( t );
+      auto key = generate_private_key( "key" + std::to_string( i ) );
+      sign( tx, key );
+      tx.signees.clear();
+      blk.transactions.emplace_back( tx );
+      keys.push_back( key.get_public_key() );
+   }
+
+   BOOST_TEST_MESSAGE( "Verify that nothing is recovered when signature checks are skipped" );
+   db.precompute_parallel( blk, database::skip_transaction_signatures );
+   for( const auto& tx : blk.transactions )
+      BOOST_CHECK( tx.signees.empty() );
+
+   BOOST_TEST_MESSAGE( "Verify that the recovered keys are cached in the transactions" );
+   db.precompute_parallel( blk );
+   for( uint32_t i = 0; i < blk.transactions.size(); ++i )
+   {
+      BOOST_REQUIRE_EQUAL( blk.transactions[i].signees.size(), 1u );
+      BOOST_CHECK( *blk.transactions[i].signees.begin() == keys[i] );
+   }
+} FC_LOG_AND_RETHROW() }
+
 BOOST_FIXTURE_TEST_CASE( change_block_interval, database_fixture )
 { try {
    generate_block();
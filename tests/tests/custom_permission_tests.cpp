@@ -358,6 +358,42 @@ BOOST_AUTO_TEST_CASE(account_authority_delete_test)
    FC_LOG_AND_RETHROW()
 }
 
+BOOST_AUTO_TEST_CASE(cached_account_authorities_follow_changes)
+{
+   try
+   {
+      INVOKE(account_authority_create_test);
+      GET_ACTOR(alice);
+      GET_ACTOR(bob);
+      transfer_operation xfer;
+      xfer.from = alice_id;
+      xfer.to = bob_id;
+      xfer.amount = asset(100);
+
+      BOOST_REQUIRE_EQUAL(db.get_cached_account_custom_authorities(alice_id, xfer).size(), 2u);
+      BOOST_CHECK(db.get_cached_account_custom_authorities(alice_id, xfer) == db.get_account_custom_authorities(alice_id, xfer));
+      BOOST_CHECK(db.get_cached_account_custom_authorities(bob_id, xfer).empty());
+
+      // a change in the same block is seen right away
+      {
+         custom_account_authority_delete_operation op;
+         op.auth_id = custom_account_authority_id_type(0);
+         op.owner_account = alice_id;
+         trx.operations.push_back(op);
+         sign(trx, alice_private_key);
+         PUSH_TX(db, trx);
+         trx.clear();
+      }
+      BOOST_CHECK_EQUAL(db.get_cached_account_custom_authorities(alice_id, xfer).size(), 1u);
+
+      // and so is the remaining authority running out
+      generate_blocks(db.head_block_time() + fc::seconds(11 * db.block_interval()));
+      BOOST_CHECK(db.get_cached_account_custom_authorities(alice_id, xfer).empty());
+      BOOST_CHECK(db.get_account_custom_authorities(alice_id, xfer).empty());
+   }
+   FC_LOG_AND_RETHROW()
+}
+
 BOOST_AUTO_TEST_CASE(permission_delete_test)
 {
    try
@@ -25,6 +25,7 @@
 #include <boost/test/unit_test.hpp>
 
 #include <graphene/app/database_api.hpp>
+#include <graphene/market_history/market_history_plugin.hpp>
 
 #include "../common/database_fixture.hpp"
 
@@ -68,4 +69,102 @@ BOOST_FIXTURE_TEST_SUITE(database_api_tests, database_fixture)
       } FC_LOG_AND_RETHROW()
   }
 
+  BOOST_AUTO_TEST_CASE(get_ticker) {
+      try {
+          using namespace graphene::market_history;
+          ACTORS((buyer)(seller));
+          const asset_object& uia = create_user_issued_asset( "TICKERUIA" );
+          const asset_object& core = asset_id_type()(db);
+          issue_uia( seller, uia.amount(1000) );
+          transfer( committee_account, buyer_id, core.amount(10000) );
+
+          create_sell_order( seller, uia.amount(100), core.amount(200) );
+          create_sell_order( buyer, core.amount(200), uia.amount(100) );
+          generate_block();
+
+          const auto& ticker_idx = db.get_index_type<market_ticker_index>().indices().get<by_market>();
+          auto itr = ticker_idx.find( boost::make_tuple( core.id, uia.id ) );
+          BOOST_REQUIRE( itr != ticker_idx.end() );
+          BOOST_CHECK_EQUAL( 200, itr->base_volume.value );
+          BOOST_CHECK_EQUAL( 100, itr->quote_volume.value );
+          BOOST_CHECK_EQUAL( 1u, itr->buckets.size() );
+
+          graphene::app::database_api db_api(db);
+          auto ticker = db_api.get_ticker( "TICKERUIA", core.symbol );
+          BOOST_CHECK_CLOSE( ticker.latest, ( 100 / pow( 10, uia.precision ) ) / ( 200 / pow( 10, core.precision ) ), 0.0001 );
+
+          // trades leave the window after a day
+          generate_blocks( db.head_block_time() + market_ticker_object::window_seconds + market_ticker_object::bucket_seconds );
+          itr = ticker_idx.find( boost::make_tuple( core.id, uia.id ) );
+          BOOST_REQUIRE( itr != ticker_idx.end() );
+          BOOST_CHECK_EQUAL( 0, itr->base_volume.value );
+          BOOST_CHECK_EQUAL( 0, itr->quote_volume.value );
+          BOOST_CHECK( itr->buckets.empty() );
+          BOOST_CHECK_EQUAL( 200, itr->last_day_base.value );
+          BOOST_CHECK_EQUAL( 100, itr->latest_quote.value );
+      } FC_LOG_AND_RETHROW()
+  }
+
+  BOOST_AUTO_TEST_CASE(list_proposed_transactions) {
+      try {
+          ACTORS((bob)(alice)(carol));
+          fund( bob, asset(1000000) );
+          fund( carol, asset(1000000) );
+
+          vector<proposal_id_type> proposals;
+          for( int i = 1; i <= 3; ++i )
+          {
+             transfer_operation top;
+             top.from = bob_id;
+             top.to = alice_id;
+             top.amount = asset(i);
+             proposal_create_operation pop;
+             pop.proposed_ops.push_back( { top } );
+             pop.expiration_time = db.head_block_time() + fc::days(1);
+             pop.fee_paying_account = bob_id;
+             trx.operations.push_back( pop );
+             sign( trx, bob_private_key );
+             processed_transaction processed = PUSH_TX( db, trx );
+             proposals.push_back( processed.operation_results.front().get<object_id_type>() );
+             trx.clear();
+          }
+
+          graphene::app::database_api db_api(db);
+          BOOST_CHECK_EQUAL( 3u, db_api.get_proposed_transactions( "bob" ).size() );
+          BOOST_CHECK( db_api.get_proposed_transactions( "carol" ).empty() );
+
+          auto page = db_api.list_proposed_transactions( "bob", proposal_id_type(), 2 );
+          BOOST_REQUIRE_EQUAL( 2u, page.size() );
+          BOOST_CHECK( page[0].id == proposals[0] );
+          BOOST_CHECK( page[1].id == proposals[1] );
+          page = db_api.list_proposed_transactions( "bob", proposal_id_type( page.back().id.instance() + 1 ), 2 );
+          BOOST_REQUIRE_EQUAL( 1u, page.size() );
+          BOOST_CHECK( page[0].id == proposals[2] );
+
+          // an account that wasn't required shows up once it approves, and is gone again when it takes the approval back
+          proposal_update_operation uop;
+          uop.proposal = proposals[1];
+          uop.fee_paying_account = carol_id;
+          uop.active_approvals_to_add.insert( carol_id );
+          trx.operations.push_back( uop );
+          sign( trx, carol_private_key );
+          PUSH_TX( db, trx );
+          trx.clear();
+
+          page = db_api.list_proposed_transactions( "carol", proposal_id_type(), 100 );
+          BOOST_REQUIRE_EQUAL( 1u, page.size() );
+          BOOST_CHECK( page[0].id == proposals[1] );
+
+          uop.active_approvals_to_add.clear();
+          uop.active_approvals_to_remove.insert( carol_id );
+          trx.operations.push_back( uop );
+          sign( trx, carol_private_key );
+          PUSH_TX( db, trx );
+          trx.clear();
+
+          BOOST_CHECK( db_api.list_proposed_transactions( "carol", proposal_id_type(), 100 ).empty() );
+          BOOST_CHECK_EQUAL( 3u, db_api.get_proposed_transactions( "bob" ).size() );
+      } FC_LOG_AND_RETHROW()
+  }
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -81,6 +81,158 @@ BOOST_AUTO_TEST_CASE( merge_test )
    }
 }
 
+BOOST_AUTO_TEST_CASE( nested_merge_undo_test )
+{
+   try {
+      database db;
+      vector<account_balance_id_type> ids;
+      auto outer = db._undo_db.start_undo_session();
+      for( int i = 0; i < 100; ++i )
+         ids.push_back( db.create<account_balance_object>( [&]( account_balance_object& obj ){
+            obj.owner = account_id_type(i);
+            obj.balance = i;
+         }).id );
+      outer.commit();
+
+      // modify, remove and re-create in a session that is merged into the next one
+      outer = db._undo_db.start_undo_session();
+      db.modify( ids[1](db), [&]( account_balance_object& obj ){ obj.balance = 501; } );
+      db.modify( ids[6](db), [&]( account_balance_object& obj ){ obj.balance = 506; } );
+      {
+         auto inner = db._undo_db.start_undo_session();
+         for( int i = 0; i < 100; i += 2 )
+            db.modify( ids[i](db), [&]( account_balance_object& obj ){ obj.balance = 1000 + i; } );
+         for( int i = 0; i < 100; i += 3 )
+            db.remove( ids[i](db) );
+         db.create<account_balance_object>( [&]( account_balance_object& obj ){
+            obj.owner = account_id_type(100);
+            obj.balance = 100;
+         });
+         inner.merge();
+      }
+      BOOST_CHECK( db.find( ids[3] ) == nullptr );
+      BOOST_CHECK_EQUAL( 1004, ids[4](db).balance.value );
+      outer.undo();
+
+      for( int i = 0; i < 100; ++i )
+         BOOST_CHECK_EQUAL( i, ids[i](db).balance.value );
+      BOOST_CHECK( db.find( account_balance_id_type(100) ) == nullptr );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( dense_lookup_test )
+{
+   try {
+      database db;
+      db.enable_dense_lookup( true );
+      vector<account_balance_id_type> ids;
+      for( int i = 0; i < 10; ++i )
+         ids.push_back( db.create<account_balance_object>( [&]( account_balance_object& obj ){
+            obj.balance = i;
+         }).id );
+      BOOST_CHECK( db.find( account_balance_id_type(10) ) == nullptr );
+      BOOST_CHECK( db.find( account_balance_id_type(5000) ) == nullptr );
+
+      {
+         auto ses = db._undo_db.start_undo_session();
+         db.remove( ids[3](db) );
+         db.create<account_balance_object>( [&]( account_balance_object& obj ){ obj.balance = 10; } );
+         BOOST_CHECK( db.find( ids[3] ) == nullptr );
+         BOOST_CHECK_EQUAL( 10, account_balance_id_type(10)(db).balance.value );
+      }
+      // the removed object is inserted again by the undo
+      BOOST_CHECK( db.find( account_balance_id_type(10) ) == nullptr );
+      BOOST_CHECK_EQUAL( 3, ids[3](db).balance.value );
+
+      db.enable_dense_lookup( false );
+      BOOST_CHECK_EQUAL( 3, ids[3](db).balance.value );
+      db.enable_dense_lookup( true );
+      for( int i = 0; i < 10; ++i )
+         BOOST_CHECK_EQUAL( i, ids[i](db).balance.value );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( undo_restores_secondary_index_test )
+{
+   try {
+      database db;
+      const auto& holders = db.get_index_type< graphene::db::primary_index< account_balance_index > >()
+                               .get_secondary_index< holders_by_asset_index >();
+      const account_balance_id_type id = db.create<account_balance_object>( [&]( account_balance_object& obj ){
+         obj.owner = account_id_type(1);
+         obj.asset_type = asset_id_type(1);
+         obj.balance = 100;
+      }).id;
+      BOOST_CHECK_EQUAL( 1u, holders.get_balance_count( asset_id_type(1) ) );
+      BOOST_CHECK_EQUAL( 1u, holders.get_holder_count( asset_id_type(1) ) );
+
+      {
+         auto ses = db._undo_db.start_undo_session();
+         db.remove( id(db) );
+         BOOST_CHECK_EQUAL( 0u, holders.get_balance_count( asset_id_type(1) ) );
+         BOOST_CHECK_EQUAL( 0u, holders.get_holder_count( asset_id_type(1) ) );
+      }
+      // the undo inserts the removed object again, the secondary index must count it again
+      BOOST_CHECK_EQUAL( 100, id(db).balance.value );
+      BOOST_CHECK_EQUAL( 1u, holders.get_balance_count( asset_id_type(1) ) );
+      BOOST_CHECK_EQUAL( 1u, holders.get_holder_count( asset_id_type(1) ) );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
+BOOST_AUTO_TEST_CASE( object_snapshot_test )
+{
+   try {
+      database db;
+      vector<account_balance_id_type> ids;
+      for( int i = 0; i < 10; ++i )
+         ids.push_back( db.create<account_balance_object>( [&]( account_balance_object& obj ){
+            obj.balance = i;
+         }).id );
+
+      graphene::db::object_snapshot snapshot( db );
+      uint32_t balances = snapshot.index_count();
+      for( uint32_t i = 0; i < snapshot.index_count(); ++i )
+         if( snapshot.space_id(i) == account_balance_object::space_id && snapshot.type_id(i) == account_balance_object::type_id )
+            balances = i;
+      BOOST_REQUIRE( balances < snapshot.index_count() );
+      BOOST_CHECK_EQUAL( 10u, snapshot.object_count( balances ) );
+
+      // changes after the snapshot was taken are not visible in it
+      db.modify( ids[2](db), []( account_balance_object& obj ){ obj.balance = 100; } );
+      db.remove( ids[5](db) );
+      db.create<account_balance_object>( [&]( account_balance_object& obj ){ obj.balance = 10; } );
+
+      vector<int64_t> seen;
+      snapshot.inspect_objects( balances, [&seen]( const graphene::db::object& o ) {
+         seen.push_back( static_cast<const account_balance_object&>(o).balance.value );
+      });
+      BOOST_REQUIRE_EQUAL( 10u, seen.size() );
+      for( int i = 0; i < 10; ++i )
+         BOOST_CHECK_EQUAL( i, seen[i] );
+
+      // objects that were read already are not copied anymore
+      db.modify( ids[3](db), []( account_balance_object& obj ){ obj.balance = 300; } );
+      BOOST_CHECK_EQUAL( 300, ids[3](db).balance.value );
+      BOOST_CHECK_EQUAL( 100, ids[2](db).balance.value );
+   } catch ( const fc::exception& e )
+   {
+      edump( (e.to_detail_string()) );
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_CASE( flat_index_test )
 {
    ACTORS((sam));
@@ -110,6 +262,32 @@ BOOST_AUTO_TEST_CASE( flat_index_test )
    FC_ASSERT( !(*bitusd.bitasset_data_id)(db).current_feed.settlement_price.is_null() );
 }
 
+BOOST_AUTO_TEST_CASE( holders_by_asset_index_test )
+{ try {
+   ACTORS((alice)(bob));
+   const auto& uia = create_user_issued_asset( "HOLDERS" );
+   const auto& holders = db.get_index_type< graphene::db::primary_index< account_balance_index > >()
+                            .get_secondary_index< holders_by_asset_index >();
+   const auto& by_balance = db.get_index_type< account_balance_index >().indices().get< by_asset_balance >();
+   BOOST_CHECK_EQUAL( 0u, holders.get_holder_count( uia.id ) );
+
+   issue_uia( alice, uia.amount(100) );
+   issue_uia( bob, uia.amount(50) );
+   BOOST_CHECK_EQUAL( 2u, holders.get_holder_count( uia.id ) );
+   BOOST_CHECK_EQUAL( 2u, holders.get_balance_count( uia.id ) );
+
+   // holders are ranked by balance
+   const auto first = by_balance.rank( by_balance.lower_bound( boost::make_tuple( uia.id ) ) );
+   BOOST_CHECK( by_balance.nth( first )->owner == alice_id );
+   BOOST_CHECK( by_balance.nth( first + 1 )->owner == bob_id );
+
+   transfer( bob, alice, uia.amount(50) );
+   BOOST_CHECK_EQUAL( 1u, holders.get_holder_count( uia.id ) );
+   BOOST_CHECK_EQUAL( 2u, holders.get_balance_count( uia.id ) );
+   BOOST_CHECK( by_balance.nth( first )->owner == alice_id );
+   BOOST_CHECK_EQUAL( 0, by_balance.nth( first + 1 )->balance.value );
+} FC_LOG_AND_RETHROW() }
+
 BOOST_AUTO_TEST_CASE( direct_index_test )
 { try {
    try {
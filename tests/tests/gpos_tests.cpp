@@ -1456,4 +1456,84 @@ BOOST_AUTO_TEST_CASE( database_api )
    }
 }
 
+BOOST_AUTO_TEST_CASE( sharded_vote_tally_matches_sequential_tally )
+{
+   try {
+      generate_blocks( HARDFORK_GPOS_TIME );
+      generate_block();
+      update_gpos_global(518400, 86400, HARDFORK_GPOS_TIME);
+      // the accounts are only tallied in shards once half a sub-period has passed
+      generate_blocks( HARDFORK_GPOS_TIME + fc::days(1) );
+      generate_block();
+
+      const auto& core = asset_id_type()(db);
+      vector<vote_id_type> witness_votes;
+      for( const witness_object& witness : db.get_index_type<witness_index>().indices() )
+         witness_votes.push_back( witness.vote_id );
+      vector<vote_id_type> committee_votes;
+      for( const committee_member_object& member : db.get_index_type<committee_member_index>().indices() )
+         committee_votes.push_back( member.vote_id );
+
+      // voters with different stakes, votes and desired numbers of witnesses and committee members
+      for( uint32_t i = 0; i < 40; ++i )
+      {
+         const account_id_type voter_id = create_account( "voter" + fc::to_string(i) ).get_id();
+         transfer( committee_account, voter_id, core.amount( 1000 + i ) );
+         create_vesting( voter_id, core.amount( 100 + 7 * i ), vesting_balance_type::gpos );
+
+         account_update_operation op;
+         op.account = voter_id;
+         op.new_options = voter_id(db).options;
+         op.new_options->num_witness = 1 + i % witness_votes.size();
+         op.new_options->votes.insert( witness_votes.begin(), witness_votes.begin() + op.new_options->num_witness );
+         op.new_options->num_committee = 1 + i % committee_votes.size();
+         op.new_options->votes.insert( committee_votes.begin(), committee_votes.begin() + op.new_options->num_committee );
+         op.extensions.value.update_last_voting_time = true;
+         trx.operations.push_back( op );
+         set_expiration( db, trx );
+         PUSH_TX( db, trx, ~0 );
+         trx.clear();
+      }
+      generate_block();
+
+      auto get_tally = [this]() {
+         vector<uint64_t> tally;
+         for( const witness_object& witness : db.get_index_type<witness_index>().indices() )
+            tally.push_back( witness.total_votes );
+         for( const committee_member_object& member : db.get_index_type<committee_member_index>().indices() )
+            tally.push_back( member.total_votes );
+         return tally;
+      };
+
+      // tally the same maintenance block in shards, then sequentially
+      db.node_properties().min_accounts_per_vote_tally_shard = 1;
+      const auto maint_time = db.get_dynamic_global_properties().next_maintenance_time;
+      const uint32_t maint_slot = std::max<uint32_t>( 1, db.get_slot_at_time( maint_time ) );
+      const signed_block maint_block = generate_block( ~0, init_account_priv_key, maint_slot - 1 );
+      BOOST_REQUIRE( db.get_dynamic_global_properties().next_maintenance_time > maint_time );
+
+      const vector<uint64_t> sharded_tally = get_tally();
+      const vector<uint64_t> sharded_witness_histogram = db.get_witness_count_histogram();
+      const vector<uint64_t> sharded_committee_histogram = db.get_committee_count_histogram();
+      const auto sharded_witnesses = db.get_global_properties().active_witnesses;
+      const auto sharded_committee = db.get_global_properties().active_committee_members;
+      BOOST_CHECK( std::any_of( sharded_tally.begin(), sharded_tally.end(), []( uint64_t votes ) { return votes > 0; } ) );
+
+      db.pop_block();
+      db.node_properties().min_accounts_per_vote_tally_shard = std::numeric_limits<size_t>::max();
+      db.push_block( maint_block, ~0 );
+      db.clear_pending();
+
+      BOOST_CHECK( get_tally() == sharded_tally );
+      BOOST_CHECK( db.get_witness_count_histogram() == sharded_witness_histogram );
+      BOOST_CHECK( db.get_committee_count_histogram() == sharded_committee_histogram );
+      BOOST_CHECK( db.get_global_properties().active_witnesses == sharded_witnesses );
+      BOOST_CHECK( db.get_global_properties().active_committee_members == sharded_committee );
+   }
+   catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
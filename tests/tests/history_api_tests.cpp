@@ -594,4 +594,56 @@ BOOST_AUTO_TEST_CASE(get_account_history_operations) {
    }
 }
 
+BOOST_AUTO_TEST_CASE(get_account_history_by_operations) {
+   try {
+      graphene::app::history_api hist_api(app);
+
+      int asset_create_op_id = operation::tag<asset_create_operation>::value;
+      int account_create_op_id = operation::tag<account_create_operation>::value;
+      int transfer_op_id = operation::tag<transfer_operation>::value;
+
+      create_bitasset("CNY", account_id_type());
+      create_account("sam");
+      create_account("alice");
+      generate_block();
+
+      // both operation types, most recent first
+      vector<operation_history_object> histories = hist_api.get_account_history_by_operations("committee-account",
+                  { asset_create_op_id, account_create_op_id }, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_REQUIRE_EQUAL(histories.size(), 3u);
+      BOOST_CHECK_EQUAL(histories[0].op.which(), account_create_op_id);
+      BOOST_CHECK_EQUAL(histories[1].op.which(), account_create_op_id);
+      BOOST_CHECK_EQUAL(histories[2].op.which(), asset_create_op_id);
+      BOOST_CHECK(histories[0].id > histories[1].id);
+      BOOST_CHECK_EQUAL(histories[2].id.instance(), 0u);
+
+      // the single type query agrees with the index
+      auto by_type = hist_api.get_account_history_operations("committee-account", account_create_op_id,
+                  operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_REQUIRE_EQUAL(by_type.size(), 2u);
+      BOOST_CHECK(by_type[0].id == histories[0].id);
+      BOOST_CHECK(by_type[1].id == histories[1].id);
+
+      // paging with start and limit
+      histories = hist_api.get_account_history_by_operations("committee-account",
+                  { asset_create_op_id, account_create_op_id }, histories[1].id, operation_history_id_type(), 1);
+      BOOST_REQUIRE_EQUAL(histories.size(), 1u);
+      BOOST_CHECK(histories[0].id == by_type[1].id);
+
+      histories = hist_api.get_account_history_by_operations("committee-account",
+                  { transfer_op_id }, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_CHECK_EQUAL(histories.size(), 0u);
+
+      // operations undone by popping the block leave the index
+      db.pop_block();
+      histories = hist_api.get_account_history_by_operations("committee-account",
+                  { asset_create_op_id, account_create_op_id }, operation_history_id_type(), operation_history_id_type(), 100);
+      BOOST_CHECK_EQUAL(histories.size(), 0u);
+
+   } catch (fc::exception &e) {
+      edump((e.to_detail_string()));
+      throw;
+   }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
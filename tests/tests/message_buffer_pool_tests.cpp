@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2015 Cryptonomex, Inc., and contributors.
+ *
+ * The MIT License
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include <graphene/net/message_buffer_pool.hpp>
+#include <graphene/net/stcp_socket.hpp>
+
+#include <fc/network/tcp_socket.hpp>
+#include <fc/thread/thread.hpp>
+
+#include <cstring>
+
+using namespace graphene::net;
+
+namespace {
+
+/** starts every test with an empty pool and puts the cap back afterwards, the pool is process wide */
+struct message_buffer_pool_fixture
+{
+   message_buffer_pool_fixture() :
+      pool( message_buffer_pool::instance() ),
+      original_max_free_bytes( pool.get_max_free_bytes() )
+   {
+      pool.set_max_free_bytes( 0 );
+      pool.set_max_free_bytes( 64 * 1024 * 1024 );
+   }
+   ~message_buffer_pool_fixture()
+   {
+      pool.set_max_free_bytes( original_max_free_bytes );
+   }
+
+   message_buffer_pool& pool;
+   const size_t original_max_free_bytes;
+};
+
+}
+
+BOOST_FIXTURE_TEST_SUITE( message_buffer_pool_tests, message_buffer_pool_fixture )
+
+BOOST_AUTO_TEST_CASE( acquire_release_round_trip )
+{
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), 0u );
+
+   const uint64_t allocated = pool.get_buffers_allocated();
+   const uint64_t reused = pool.get_buffers_reused();
+
+   std::shared_ptr<char> buffer = pool.get_buffer( 1000 );
+   const char* first_buffer = buffer.get();
+   BOOST_CHECK_EQUAL( pool.get_buffers_allocated(), allocated + 1 );
+
+   // a copy keeps the buffer out of the pool, the last reference puts it back
+   std::shared_ptr<char> copy = buffer;
+   buffer.reset();
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), 0u );
+   copy.reset();
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), message_buffer_pool::smallest_buffer_size );
+
+   buffer = pool.get_buffer( 2000 );
+   BOOST_CHECK( buffer.get() == first_buffer );
+   BOOST_CHECK_EQUAL( pool.get_buffers_allocated(), allocated + 1 );
+   BOOST_CHECK_EQUAL( pool.get_buffers_reused(), reused + 1 );
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( size_class_boundaries )
+{
+   const size_t smallest = message_buffer_pool::smallest_buffer_size;
+   const size_t largest = message_buffer_pool::largest_buffer_size;
+
+   pool.get_buffer( smallest );
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), smallest );
+
+   // one byte past a size class needs the next one
+   const uint64_t allocated = pool.get_buffers_allocated();
+   {
+      std::shared_ptr<char> buffer = pool.get_buffer( smallest + 1 );
+      BOOST_CHECK_EQUAL( pool.get_buffers_allocated(), allocated + 1 );
+      BOOST_CHECK_EQUAL( pool.get_free_bytes(), smallest );
+   }
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), 3 * smallest );
+
+   // the exact size of a class is served from that class
+   pool.get_buffer( 2 * smallest );
+   BOOST_CHECK_EQUAL( pool.get_buffers_allocated(), allocated + 1 );
+
+   pool.get_buffer( largest );
+   BOOST_CHECK_EQUAL( pool.get_buffers_allocated(), allocated + 2 );
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), 3 * smallest + largest );
+
+   // anything larger than the largest class isn't pooled
+   pool.get_buffer( largest + 1 );
+   BOOST_CHECK_EQUAL( pool.get_buffers_allocated(), allocated + 3 );
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), 3 * smallest + largest );
+}
+
+BOOST_AUTO_TEST_CASE( free_bytes_are_capped_across_size_classes )
+{
+   const size_t smallest = message_buffer_pool::smallest_buffer_size;
+   pool.set_max_free_bytes( 4 * smallest );
+
+   {
+      std::vector<std::shared_ptr<char>> buffers;
+      buffers.push_back( pool.get_buffer( smallest ) );
+      buffers.push_back( pool.get_buffer( smallest ) );
+      buffers.push_back( pool.get_buffer( 2 * smallest ) );
+      buffers.push_back( pool.get_buffer( smallest ) );
+   }
+   // the last buffer released would have gone past the cap
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), 4 * smallest );
+
+   // lowering the cap drops the largest free buffers first
+   pool.set_max_free_bytes( 2 * smallest );
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), 2 * smallest );
+   const uint64_t allocated = pool.get_buffers_allocated();
+   pool.get_buffer( smallest );
+   BOOST_CHECK_EQUAL( pool.get_buffers_allocated(), allocated );
+   pool.get_buffer( 2 * smallest );
+   BOOST_CHECK_EQUAL( pool.get_buffers_allocated(), allocated + 1 );
+
+   pool.set_max_free_bytes( 0 );
+   BOOST_CHECK_EQUAL( pool.get_free_bytes(), 0u );
+}
+
+BOOST_AUTO_TEST_CASE( stcp_socket_frames_round_trip )
+{
+   fc::tcp_server server;
+   server.listen( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), 0 ) );
+
+   stcp_socket server_socket;
+   fc::future<void> accepted = fc::async( [&](){
+      server.accept( server_socket.get_socket() );
+      server_socket.accept();
+   }, "accept stcp connection" );
+   stcp_socket client_socket;
+   client_socket.connect_to( fc::ip::endpoint( fc::ip::address( "127.0.0.1" ), server.get_local_endpoint().port() ) );
+   accepted.wait();
+
+   // one frame that fits the socket's own read buffer and one that is read through a pooled buffer
+   for( size_t len : { size_t(64), size_t(64 * 1024) } )
+   {
+      std::shared_ptr<char> frame = pool.get_buffer( len );
+      for( size_t i = 0; i < len; ++i )
+         frame.get()[i] = char( i * 7 + len );
+      std::vector<char> plaintext( frame.get(), frame.get() + len );
+
+      // once into a shared buffer, decrypted where it lands
+      client_socket.write_frame( frame, len );
+      client_socket.flush();
+      BOOST_CHECK( memcmp( frame.get(), plaintext.data(), len ) == 0 );
+
+      std::shared_ptr<char> received = pool.get_buffer( len );
+      size_t received_len = 0;
+      while( received_len < len )
+         received_len += server_socket.readsome( received, len - received_len, received_len );
+      BOOST_REQUIRE_EQUAL( received_len, len );
+      BOOST_CHECK( memcmp( received.get(), plaintext.data(), len ) == 0 );
+
+      // and once through the socket's read path
+      client_socket.write_frame( frame, len );
+      client_socket.flush();
+
+      std::vector<char> read_back( len );
+      received_len = 0;
+      while( received_len < len )
+         received_len += server_socket.readsome( read_back.data() + received_len, len - received_len );
+      BOOST_REQUIRE_EQUAL( received_len, len );
+      BOOST_CHECK( read_back == plaintext );
+   }
+
+   client_socket.close();
+   server_socket.close();
+   server.close();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
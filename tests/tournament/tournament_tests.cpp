@@ -2255,6 +2255,87 @@ BOOST_FIXTURE_TEST_CASE( massive, database_fixture )
 }
 #endif
 
+// everything the progress of the tournaments is made of
+static std::string get_tournament_state(const database& db)
+{
+    std::string state;
+    for (const tournament_object& tournament : db.get_index_type<tournament_index>().indices())
+        state += fc::json::to_string(fc::variant(tournament, GRAPHENE_MAX_NESTED_OBJECTS));
+    for (const tournament_details_object& details : db.get_index_type<tournament_details_index>().indices())
+        state += fc::json::to_string(fc::variant(details, GRAPHENE_MAX_NESTED_OBJECTS));
+    for (const match_object& match : db.get_index_type<match_index>().indices())
+        state += fc::json::to_string(fc::variant(match, GRAPHENE_MAX_NESTED_OBJECTS));
+    for (const game_object& game : db.get_index_type<game_index>().indices())
+        state += fc::json::to_string(fc::variant(game, GRAPHENE_MAX_NESTED_OBJECTS));
+    return state;
+}
+
+// The tournaments checked for new matches are queued outside of the undo state.  Applying a popped
+// block again, or replaying blocks after a restart, must start the same matches as the first time.
+BOOST_FIXTURE_TEST_CASE( pending_tournaments_survive_popped_blocks_and_restarts, database_fixture )
+{
+    try
+    {
+        ACTORS((nathan)(alice)(bob)(carol)(dave));
+
+        tournaments_helper tournament_helper(*this);
+        fc::ecc::private_key nathan_priv_key = fc::ecc::private_key::regenerate(fc::sha256::hash(string("nathan")));
+        transfer(committee_account, nathan_id, asset(1000000000));
+        transfer(committee_account, alice_id,  asset(2000000));
+        transfer(committee_account, bob_id,    asset(2000000));
+        transfer(committee_account, carol_id,  asset(2000000));
+        transfer(committee_account, dave_id,   asset(2000000));
+        upgrade_to_lifetime_member(nathan);
+
+        asset buy_in = asset(12000);
+        tournament_id_type tournament_id = tournament_helper.create_tournament(nathan_id, nathan_priv_key, buy_in, 4);
+        tournament_helper.join_tournament(tournament_id, alice_id, alice_id, fc::ecc::private_key::regenerate(fc::sha256::hash(string("alice"))), buy_in);
+        tournament_helper.join_tournament(tournament_id, bob_id, bob_id, fc::ecc::private_key::regenerate(fc::sha256::hash(string("bob"))), buy_in);
+        tournament_helper.join_tournament(tournament_id, carol_id, carol_id, fc::ecc::private_key::regenerate(fc::sha256::hash(string("carol"))), buy_in);
+        tournament_helper.join_tournament(tournament_id, dave_id, dave_id, fc::ecc::private_key::regenerate(fc::sha256::hash(string("dave"))), buy_in);
+
+        // every block is popped and applied again, which must lead to the same state
+        auto generate_block_twice = [&](database& d) {
+            signed_block block = d.generate_block(d.get_slot_time(1), d.get_scheduled_witness(1), init_account_priv_key, ~0);
+            const std::string state = get_tournament_state(d);
+            d.pop_block();
+            d.push_block(block, ~0);
+            d.clear_pending();
+            BOOST_CHECK_EQUAL(get_tournament_state(d), state);
+        };
+        auto has_completed_match = [&](const database& d) {
+            for (const match_id_type& match_id : tournament_id(d).tournament_details_id(d).matches)
+                if (match_id(d).get_state() == match_state::match_complete)
+                    return true;
+            return false;
+        };
+
+        BOOST_TEST_MESSAGE("Playing the first matches");
+        for (uint32_t i = 0; i < 1000 && !has_completed_match(db); ++i)
+            generate_block_twice(db);
+        BOOST_REQUIRE(has_completed_match(db));
+        BOOST_REQUIRE(tournament_id(db).get_state() == tournament_state::in_progress);
+
+        BOOST_TEST_MESSAGE("Restarting, which replays the blocks after the last irreversible one");
+        const std::string state = get_tournament_state(db);
+        db.close();
+        database restarted_db;
+        restarted_db.open(data_dir->path(), [this]{return genesis_state;}, "test");
+        BOOST_CHECK_EQUAL(get_tournament_state(restarted_db), state);
+
+        BOOST_TEST_MESSAGE("Playing the tournament to its end");
+        for (uint32_t i = 0; i < 1000 && tournament_id(restarted_db).get_state() != tournament_state::concluded; ++i)
+            generate_block_twice(restarted_db);
+        BOOST_CHECK(tournament_id(restarted_db).get_state() == tournament_state::concluded);
+        restarted_db.close();
+    }
+    catch (fc::exception& e)
+    {
+        edump((e.to_detail_string()));
+        throw;
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 //#define BOOST_TEST_MODULE "C++ Unit Tests for Graphene Blockchain Database"